@@ -0,0 +1,95 @@
+/**
+ * libMSDF WASM benchmark - throughput of the bundled module in Node
+ *
+ * Counterpart of bench/bench_native.cpp. Reports module init and font load time, then
+ * glyphs/sec per size for single glyph calls (glyph cache off), generateBatch(),
+ * generateAtlas() and cached single glyph calls. LIBMSDF_MT=1 runs the threaded build.
+ */
+
+import * as fs from 'fs';
+import * as path from 'path';
+import { fileURLToPath } from 'url';
+
+const __filename = fileURLToPath(import.meta.url);
+const __dirname = path.dirname(__filename);
+
+const ITERATIONS = 3;
+const SIZES = [16, 32, 64, 128];
+const PIXEL_RANGE = 4.0;
+const FONTS = ['Poppins-Regular.ttf', 'Inter-VariableFont_opsz,wght.ttf'];
+
+// Printable ASCII, same set as the native benchmark
+const CHARSET = Array.from({ length: 127 - 33 }, (_, i) => i + 33);
+
+function time(fn: () => void): number {
+    const start = performance.now();
+    fn();
+    return performance.now() - start;
+}
+
+function rate(glyphs: number, ms: number): string {
+    return Math.round(glyphs * 1000 / ms).toString().padStart(12);
+}
+
+async function main() {
+    const bundle = process.env.LIBMSDF_MT ? 'libMSDF-mt' : 'libMSDF';
+    const { MSDFGenerator } = await import(path.join(__dirname, bundle + '.js'));
+
+    let msdf: any;
+    const initMs = await (async () => {
+        const start = performance.now();
+        msdf = await MSDFGenerator.init(path.join(__dirname, bundle + '.wasm'));
+        return performance.now() - start;
+    })();
+    console.log(`\n=== libMSDF WASM Benchmark (${bundle}, ${msdf.threadCount} thread(s)) ===`);
+    console.log(`init: ${initMs.toFixed(1)} ms`);
+
+    for (const font of FONTS) {
+        const fontPath = path.join(__dirname, 'assets', font);
+        if (!fs.existsSync(fontPath)) {
+            console.log(`\nSKIP: ${font} not found`);
+            continue;
+        }
+        const fontBytes = new Uint8Array(fs.readFileSync(fontPath));
+
+        let loadMs = 0;
+        for (let i = 0; i < ITERATIONS; i++) loadMs += time(() => msdf.loadFont(fontBytes));
+        loadMs /= ITERATIONS;
+
+        console.log(`\n${font} (${Math.round(fontBytes.byteLength / 1024)} KB, font load ${loadMs.toFixed(3)} ms, mtsdf, range ${PIXEL_RANGE}, ${CHARSET.length} glyphs)`);
+        console.log(`  ${'size'.padStart(6)}  ${'single gl/s'.padStart(12)}  ${'batch gl/s'.padStart(12)}  ${'atlas gl/s'.padStart(12)}  ${'cached gl/s'.padStart(12)}`);
+
+        for (const size of SIZES) {
+            const glyphs = CHARSET.length * ITERATIONS;
+            let single = 0, batch = 0, atlas = 0, cached = 0;
+
+            msdf.setCacheBudget(0);
+            for (let i = 0; i < ITERATIONS; i++) {
+                single += time(() => {
+                    for (const code of CHARSET) msdf.generateMTSDF(code, size, PIXEL_RANGE);
+                });
+                batch += time(() => msdf.generateBatch(CHARSET, size, PIXEL_RANGE, 'mtsdf'));
+                atlas += time(() => msdf.generateAtlas(CHARSET, size, PIXEL_RANGE, 4096, 'mtsdf'));
+            }
+
+            msdf.setCacheBudget(64 * 1024 * 1024);
+            for (const code of CHARSET) msdf.generateMTSDF(code, size, PIXEL_RANGE); // warm up
+            for (let i = 0; i < ITERATIONS; i++) {
+                cached += time(() => {
+                    for (const code of CHARSET) msdf.generateMTSDF(code, size, PIXEL_RANGE);
+                });
+            }
+            msdf.clearCache();
+
+            console.log(`  ${size.toString().padStart(6)}  ${rate(glyphs, single)}  ${rate(glyphs, batch)}  ${rate(glyphs, atlas)}  ${rate(glyphs, cached)}`);
+        }
+    }
+
+    msdf.dispose();
+    process.exit(0); // Explicit: pthread workers would keep Node alive
+}
+
+main().catch(e => {
+    console.error(e);
+    process.exit(1);
+});
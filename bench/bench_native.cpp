@@ -0,0 +1,262 @@
+// Native benchmark for the MSDF "Minimal Core".
+// Build and run with: make -f Makefile.native bench
+//
+// For every font and size, reports end-to-end throughput (glyphs/sec, cold and warm
+// shape cache) and the average time per glyph of each stage: glyph load (FreeType
+// outline decomposition), edge coloring (normalize + edgeColoringSimple), rasterization
+// (generateMSDF / generateMTSDF) and pixel pack (uint8 quantization).
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+#include "core.h"
+#include "thread_pool.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static bool readFile(const char* path, std::vector<uint8_t>& out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    out.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !out.empty();
+}
+
+struct StageTimes {
+    double fontLoad = 0;    // Per open, ms
+    double glyphLoad = 0;   // Per glyph, ms (summed over a pass)
+    double coloring = 0;
+    double raster = 0;
+    double pack = 0;
+};
+
+struct Options {
+    int iterations = 3;
+    int mode = msdf_core::MODE_MTSDF;
+    double pixelRange = 4.0;
+    msdf_core::RasterOptions raster;
+    std::vector<double> sizes = {16, 32, 64, 128};
+    std::vector<const char*> fonts;
+};
+
+static void usage() {
+    std::fprintf(stderr,
+        "usage: bench_native [--iterations N] [--mode sdf|msdf|mtsdf] [--precision exact|fast] [--correction off|edge|full|auto] [--sparse] [--grid] [--range R] [--sizes 16,32,...] font.ttf...\n");
+}
+
+static bool parseArgs(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(arg, "--iterations") && hasValue) {
+            opt.iterations = std::max(1, std::atoi(argv[++i]));
+        } else if (!std::strcmp(arg, "--mode") && hasValue) {
+            const char* mode = argv[++i];
+            if (!std::strcmp(mode, "msdf")) opt.mode = msdf_core::MODE_MSDF;
+            else if (!std::strcmp(mode, "mtsdf")) opt.mode = msdf_core::MODE_MTSDF;
+            else if (!std::strcmp(mode, "sdf")) opt.mode = msdf_core::MODE_SDF;
+            else return false;
+        } else if (!std::strcmp(arg, "--precision") && hasValue) {
+            const char* precision = argv[++i];
+            if (!std::strcmp(precision, "exact")) opt.raster.precision = msdf_core::PRECISION_EXACT;
+            else if (!std::strcmp(precision, "fast")) opt.raster.precision = msdf_core::PRECISION_FAST;
+            else return false;
+        } else if (!std::strcmp(arg, "--correction") && hasValue) {
+            const char* correction = argv[++i];
+            if (!std::strcmp(correction, "off")) opt.raster.correction = msdf_core::CORRECTION_OFF;
+            else if (!std::strcmp(correction, "edge")) opt.raster.correction = msdf_core::CORRECTION_EDGE_ONLY;
+            else if (!std::strcmp(correction, "full")) opt.raster.correction = msdf_core::CORRECTION_FULL;
+            else if (!std::strcmp(correction, "auto")) opt.raster.correction = msdf_core::CORRECTION_AUTO;
+            else return false;
+        } else if (!std::strcmp(arg, "--sparse")) {
+            opt.raster.sparse = true;
+        } else if (!std::strcmp(arg, "--grid")) {
+            opt.raster.grid = true;
+        } else if (!std::strcmp(arg, "--range") && hasValue) {
+            opt.pixelRange = std::atof(argv[++i]);
+        } else if (!std::strcmp(arg, "--sizes") && hasValue) {
+            opt.sizes.clear();
+            for (char* token = std::strtok(argv[++i], ","); token; token = std::strtok(nullptr, ",")) {
+                opt.sizes.push_back(std::atof(token));
+            }
+        } else if (arg[0] == '-') {
+            return false;
+        } else {
+            opt.fonts.push_back(arg);
+        }
+    }
+    return !opt.fonts.empty() && !opt.sizes.empty();
+}
+
+// Printable ASCII: the usual UI / editor working set
+static std::vector<uint32_t> benchCharset() {
+    std::vector<uint32_t> codepoints;
+    for (uint32_t c = 33; c < 127; ++c) codepoints.push_back(c);
+    return codepoints;
+}
+
+// Time each stage separately for one pass over the charset (outlines loaded without the shape cache)
+static void measureStages(msdf_core::FontSession& session, const std::vector<uint32_t>& charset,
+                          double fontSize, const Options& opt, StageTimes& times,
+                          std::vector<float>& pixels, std::vector<uint8_t>& bytes) {
+    int channels = msdf_core::modeChannels(opt.mode);
+    for (uint32_t codepoint : charset) {
+        msdfgen::GlyphIndex glyphIndex;
+        msdfgen::getGlyphIndex(glyphIndex, session.font, codepoint);
+
+        Clock::time_point start = Clock::now();
+        msdfgen::Shape shape;
+        double advance;
+        if (!msdfgen::loadGlyph(shape, session.font, glyphIndex, &advance)) continue;
+        times.glyphLoad += elapsedMs(start);
+
+        start = Clock::now();
+        shape.normalize();
+        msdfgen::edgeColoringSimple(shape, 3.0);
+        times.coloring += elapsedMs(start);
+
+        // Frame math from prepareGlyph (its outline comes from the warm shape cache here)
+        msdf_core::GlyphGeometry glyph;
+        if (!msdf_core::prepareGlyph(session, codepoint, fontSize, opt.pixelRange, glyph)) continue;
+        size_t samples = (size_t)glyph.width * glyph.height * channels;
+        if (pixels.size() < samples) pixels.resize(samples);
+        if (bytes.size() < samples) bytes.resize(samples);
+
+        msdf_core::PixelTarget target;
+        target.data = pixels.data();
+        target.width = glyph.width;
+        target.height = glyph.height;
+        target.rowStride = 0;
+        target.format = msdf_core::FORMAT_FLOAT32;
+
+        start = Clock::now();
+        msdf_core::renderInto(target, channels, glyph, opt.pixelRange, opt.raster);
+        times.raster += elapsedMs(start);
+
+        start = Clock::now();
+        msdf_core::quantizePixels(pixels.data(), bytes.data(), samples);
+        times.pack += elapsedMs(start);
+    }
+}
+
+// End-to-end prepare + render of the whole charset; returns ms for the pass
+static double runPass(msdf_core::FontSession& session, const std::vector<uint32_t>& charset,
+                      double fontSize, const Options& opt, bool parallel) {
+    int channels = msdf_core::modeChannels(opt.mode);
+    int count = (int)charset.size();
+    std::vector<msdf_core::GlyphGeometry> geometry(count);
+    std::vector<std::vector<float>> pixels(count);
+
+    Clock::time_point start = Clock::now();
+    auto glyphFn = [&](msdf_core::FontSession& face, int i) {
+        if (!msdf_core::prepareGlyph(face, charset[i], fontSize, opt.pixelRange, geometry[i])) return;
+        pixels[i].resize((size_t)geometry[i].width * geometry[i].height * channels);
+        msdf_core::PixelTarget target;
+        target.data = pixels[i].data();
+        target.width = geometry[i].width;
+        target.height = geometry[i].height;
+        target.rowStride = 0;
+        target.format = msdf_core::FORMAT_FLOAT32;
+        msdf_core::renderInto(target, channels, geometry[i], opt.pixelRange, opt.raster);
+    };
+    if (parallel) {
+        msdf_core::parallelGlyphs(session, count, glyphFn);
+    } else {
+        for (int i = 0; i < count; ++i) glyphFn(session, i);
+    }
+    return elapsedMs(start);
+}
+
+static bool benchFont(const char* path, const Options& opt) {
+    std::vector<uint8_t> data;
+    if (!readFile(path, data)) {
+        std::fprintf(stderr, "cannot read %s\n", path);
+        return false;
+    }
+
+    StageTimes times;
+    msdf_core::FontSession* session = nullptr;
+    for (int i = 0; i < opt.iterations; ++i) {
+        if (session) msdf_core::closeFont(session);
+        Clock::time_point start = Clock::now();
+        session = msdf_core::openFont(std::vector<uint8_t>(data));
+        times.fontLoad += elapsedMs(start);
+        if (!session) {
+            std::fprintf(stderr, "cannot load %s\n", path);
+            return false;
+        }
+    }
+    times.fontLoad /= opt.iterations;
+
+    const char* name = std::strrchr(path, '/');
+    name = name ? name + 1 : path;
+    std::vector<uint32_t> charset = benchCharset();
+    int threads = msdf_core::threadCount();
+    static const char* const corrections[] = { "", " ec-off", " ec-edge", " ec-full", " ec-auto" };
+
+    std::printf("\n%s (%zu KB, font load %.3f ms, %s, %s%s%s%s, range %.1f, %d glyphs",
+                name, data.size() / 1024, times.fontLoad,
+                opt.mode == msdf_core::MODE_MTSDF ? "mtsdf" : (opt.mode == msdf_core::MODE_SDF ? "sdf" : "msdf"),
+                opt.raster.precision == msdf_core::PRECISION_FAST ? "fast" : "exact", corrections[opt.raster.correction],
+                opt.raster.sparse ? " sparse" : "", opt.raster.grid ? " grid" : "", opt.pixelRange, (int)charset.size());
+    if (threads > 1) std::printf(", %d threads", threads);
+    std::printf(")\n");
+    std::printf("  %6s  %12s  %12s  %12s  %10s  %10s  %10s  %10s\n",
+                "size", "cold gl/s", "warm gl/s", threads > 1 ? "mt gl/s" : "-",
+                "load us", "color us", "raster us", "pack us");
+
+    std::vector<float> pixels;
+    std::vector<uint8_t> bytes;
+    for (double size : opt.sizes) {
+        StageTimes stage;
+        double cold = 0, warm = 0, mt = 0;
+        for (int i = 0; i < opt.iterations; ++i) {
+            session->shapes->clear();
+            cold += runPass(*session, charset, size, opt, false);
+            warm += runPass(*session, charset, size, opt, false);
+            if (threads > 1) {
+                session->shapes->clear();
+                mt += runPass(*session, charset, size, opt, true);
+            }
+            measureStages(*session, charset, size, opt, stage, pixels, bytes);
+        }
+
+        double glyphs = (double)charset.size() * opt.iterations;
+        double perGlyphUs = 1000.0 / glyphs;
+        std::printf("  %6.0f  %12.0f  %12.0f  %12s  %10.2f  %10.2f  %10.2f  %10.2f\n",
+                    size, glyphs * 1000.0 / cold, glyphs * 1000.0 / warm,
+                    threads > 1 ? std::to_string((long long)(glyphs * 1000.0 / mt)).c_str() : "-",
+                    stage.glyphLoad * perGlyphUs, stage.coloring * perGlyphUs,
+                    stage.raster * perGlyphUs, stage.pack * perGlyphUs);
+    }
+
+    msdf_core::closeFont(session);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) {
+        usage();
+        return 2;
+    }
+
+    int cores = (int)std::thread::hardware_concurrency();
+    msdf_core::setThreadCount(cores > 0 ? cores : 1);
+
+    bool ok = true;
+    for (const char* font : opt.fonts) {
+        ok = benchFont(font, opt) && ok;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,175 @@
+/**
+ * Persistent atlas cache - atlas files (msdf_core::AtlasFileHeader) read back without WASM,
+ * and stores that keep them across page loads (IndexedDB) or process runs (filesystem).
+ */
+
+import type { MSDFAtlas, MSDFAtlasChar, MSDFMode, MSDFOutputLayout, MSDFPixelFormat } from './msdf-generator.js';
+
+const ATLAS_FILE_MAGIC = 0x4144534d; // "MSDA"
+const ATLAS_FILE_VERSION = 1;
+const HEADER_BYTES = 64;
+const AXIS_BYTES = 8;
+const GLYPH_BYTES = 36;
+const FILE_MODES: MSDFMode[] = ['msdf', 'mtsdf', 'sdf'];
+
+// An atlas read from an atlas file, with the settings it was generated with
+export interface MSDFAtlasFile extends MSDFAtlas {
+    mode: MSDFMode;
+    format: MSDFPixelFormat;
+    fontSize: number;
+    pixelRange: number;
+    layout: Required<MSDFOutputLayout>; // Layout the page was generated in (see MSDFGenerator.setOutputLayout())
+    key: string;    // Persistent cache key (see MSDFGenerator.atlasCacheKey())
+}
+
+/**
+ * Where generateAtlasCached() keeps atlas files. Keys are short hex strings, values the
+ * files as generateAtlasFile() returns them. Errors on get() count as a miss.
+ */
+export interface MSDFAtlasStore {
+    get(key: string): Promise<Uint8Array | null>;
+    set(key: string, data: Uint8Array): Promise<void>;
+}
+
+function hex32(value: number): string {
+    return (value >>> 0).toString(16).padStart(8, '0');
+}
+
+// Cache key of a file: font hash, then settings hash (both 64-bit, high word first)
+export function atlasKeyFromWords(words: ArrayLike<number>): string {
+    return `${hex32(words[1])}${hex32(words[0])}-${hex32(words[3])}${hex32(words[2])}`;
+}
+
+/**
+ * Read an atlas file. The pixel page is a view into data, not a copy (for 'float32' files
+ * whose page is not 4-byte aligned in memory, a copy), so it can go to a texture upload as is.
+ * @return The atlas, or null if data is not a complete atlas file of this version
+ */
+export function parseAtlasFile(data: Uint8Array): MSDFAtlasFile | null {
+    if (data.byteLength < HEADER_BYTES) return null;
+    const view = new DataView(data.buffer, data.byteOffset, data.byteLength);
+    const u32 = (offset: number) => view.getUint32(offset, true);
+    const f32 = (offset: number) => view.getFloat32(offset, true);
+
+    if (u32(0) !== ATLAS_FILE_MAGIC || view.getUint16(4, true) !== ATLAS_FILE_VERSION ||
+        view.getUint16(6, true) !== HEADER_BYTES) return null;
+    const mode = FILE_MODES[view.getUint8(8)];
+    const format: MSDFPixelFormat = view.getUint8(9) === 1 ? 'uint8' : 'float32';
+    const channels = view.getUint8(10);
+    const layoutBits = view.getUint8(11); // msdf_core::OutputLayout::key()
+    const layout = { topDown: (layoutBits & 1) !== 0, rowAlignment: 1 << (layoutBits >> 2), padToRGBA: (layoutBits & 2) !== 0 };
+    const width = u32(12), height = u32(16);
+    const glyphCount = u32(20), axisCount = u32(24);
+    const glyphOffset = u32(52), pixelOffset = u32(56), pixelBytes = u32(60);
+    const sampleBytes = format === 'uint8' ? 1 : 4;
+    const rowBytes = Math.ceil(width * channels * sampleBytes / layout.rowAlignment) * layout.rowAlignment;
+    if (!mode || glyphOffset < HEADER_BYTES + axisCount * AXIS_BYTES ||
+        glyphOffset + glyphCount * GLYPH_BYTES > pixelOffset || pixelOffset + pixelBytes > data.byteLength ||
+        pixelBytes !== rowBytes * height) return null;
+
+    const chars: MSDFAtlasChar[] = [];
+    const missing: number[] = [];
+    for (let i = 0; i < glyphCount; i++) {
+        const g = glyphOffset + i * GLYPH_BYTES;
+        if (u32(g + 4) === 0) {
+            missing.push(u32(g));
+            continue;
+        }
+        chars.push({
+            id: u32(g),
+            x: u32(g + 8), y: u32(g + 12),
+            width: u32(g + 16), height: u32(g + 20),
+            xoffset: f32(g + 24), yoffset: f32(g + 28),
+            xadvance: f32(g + 32)
+        });
+    }
+
+    let pixels: Float32Array | Uint8Array;
+    const start = data.byteOffset + pixelOffset;
+    if (format === 'uint8') {
+        pixels = new Uint8Array(data.buffer, start, pixelBytes);
+    } else if (start % 4 === 0) {
+        pixels = new Float32Array(data.buffer, start, pixelBytes / 4);
+    } else {
+        pixels = new Float32Array(data.slice(pixelOffset, pixelOffset + pixelBytes).buffer);
+    }
+
+    return {
+        width, height, channels, rowStride: rowBytes / sampleBytes, pixels, chars, missing,
+        mode, format, fontSize: f32(28), pixelRange: f32(32), layout,
+        key: atlasKeyFromWords([u32(36), u32(40), u32(44), u32(48)])
+    };
+}
+
+/**
+ * Browser store: one IndexedDB object store of atlas files.
+ */
+export class IndexedDBAtlasStore implements MSDFAtlasStore {
+    private db: Promise<IDBDatabase> | null = null;
+
+    /**
+     * @param databaseName IndexedDB database (created on first use)
+     * @param storeName Object store inside it
+     */
+    constructor(private databaseName: string = 'libMSDF', private storeName: string = 'atlases') {}
+
+    async get(key: string): Promise<Uint8Array | null> {
+        const db = await this.open();
+        const value = await this.request<unknown>(db.transaction(this.storeName, 'readonly')
+            .objectStore(this.storeName).get(key));
+        if (value instanceof ArrayBuffer) return new Uint8Array(value);
+        return value instanceof Uint8Array ? value : null;
+    }
+
+    async set(key: string, data: Uint8Array): Promise<void> {
+        const db = await this.open();
+        // Store exactly the file's bytes, not the rest of a larger buffer it may view
+        const bytes = data.slice().buffer;
+        await this.request(db.transaction(this.storeName, 'readwrite').objectStore(this.storeName).put(bytes, key));
+    }
+
+    private open(): Promise<IDBDatabase> {
+        if (!this.db) {
+            const request = indexedDB.open(this.databaseName, 1);
+            request.onupgradeneeded = () => request.result.createObjectStore(this.storeName);
+            this.db = this.request(request);
+        }
+        return this.db;
+    }
+
+    private request<T>(request: IDBRequest<T>): Promise<T> {
+        return new Promise((resolve, reject) => {
+            request.onsuccess = () => resolve(request.result);
+            request.onerror = () => reject(request.error);
+        });
+    }
+}
+
+/**
+ * Node store: one '<key>.msda' file per atlas in a directory (created on first write).
+ * Files are written under a temporary name and renamed, so readers never see partial files.
+ */
+export class FileAtlasStore implements MSDFAtlasStore {
+    constructor(private directory: string) {}
+
+    async get(key: string): Promise<Uint8Array | null> {
+        const fs = await import('fs/promises');
+        try {
+            return await fs.readFile(this.path(key)); // A Buffer is a Uint8Array
+        } catch (e) {
+            return null;
+        }
+    }
+
+    async set(key: string, data: Uint8Array): Promise<void> {
+        const fs = await import('fs/promises');
+        await fs.mkdir(this.directory, { recursive: true });
+        const temporary = `${this.path(key)}.${Date.now()}${Math.random().toString(36).slice(2)}.tmp`;
+        await fs.writeFile(temporary, data);
+        await fs.rename(temporary, this.path(key));
+    }
+
+    private path(key: string): string {
+        return `${this.directory.replace(/[\\/]+$/, '')}/${key}.msda`;
+    }
+}
@@ -0,0 +1,27 @@
+/**
+ * libMSDF (threaded) - same API as index.ts, backed by the pthreads WASM build.
+ *
+ * Batch and atlas generation run on a pool with one thread per logical core.
+ * Requires SharedArrayBuffer: serve the page cross-origin isolated (COOP/COEP headers).
+ * Use the single-threaded libMSDF.js everywhere else.
+ */
+
+// @ts-ignore - Emscripten generated module, bundled by esbuild
+import LibMSDFFactoryMT from '../build/libmsdf-core-mt.js';
+import { setModuleBuild } from './msdf-generator.js';
+
+// Must match -sPTHREAD_POOL_SIZE in Makefile.wasm
+const threads: number = (globalThis as any).navigator?.hardwareConcurrency || 4;
+
+setModuleBuild({
+    // Pthread workers load this bundle, not the raw Emscripten glue
+    factory: (options: object) => LibMSDFFactoryMT({ ...options, mainScriptUrlOrBlob: import.meta.url }),
+    threads
+});
+
+export { MSDFGenerator, MSDFGlyph, MSDFMetrics } from './msdf-generator.js';
+export { MSDFWorker } from './msdf-worker.js';
+export { parseAtlasFile, IndexedDBAtlasStore, FileAtlasStore } from './atlas-cache.js';
+export type { MSDFInitOptions, MSDFFontHandle, VariationAxis, MSDFMode, MSDFPixelFormat, MSDFPrecision, MSDFErrorCorrection, MSDFOutputLayout, MSDFFontMetrics, MSDFKerningPair, MSDFAtlas, MSDFAtlasChar, MSDFAtlasLevel, MSDFAtlasPyramid, MSDFStagingBuffer, MSDFIntoResult, MSDFCacheStats, MSDFStats, MSDFGlyphStats, MSDFAsyncOptions, MSDFStreamSlice, MSDFAtlasRect, MSDFAtlasUpdate, MSDFAtlasStreamOptions } from './msdf-generator.js';
+export type { MSDFWorkerMethod } from './msdf-worker.js';
+export type { MSDFAtlasFile, MSDFAtlasStore } from './atlas-cache.js';
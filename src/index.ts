@@ -4,5 +4,17 @@
  * Low-level MSDF glyph generation. For atlas management and caching, see kitAtlas.
  */
 
+// @ts-ignore - Emscripten generated module, bundled by esbuild
+import LibMSDFFactory from '../build/libmsdf-core.js';
+// @ts-ignore - SIMD128 variant (libMSDF-simd.wasm), picked at init when supported
+import LibMSDFFactorySIMD from '../build/libmsdf-core-simd.js';
+import { setModuleBuild } from './msdf-generator.js';
+
+setModuleBuild({ factory: LibMSDFFactory, simdFactory: LibMSDFFactorySIMD, threads: 1 });
+
 export { MSDFGenerator, MSDFGlyph, MSDFMetrics } from './msdf-generator.js';
-export type { VariationAxis } from './msdf-generator.js';
+export { MSDFWorker } from './msdf-worker.js';
+export { parseAtlasFile, IndexedDBAtlasStore, FileAtlasStore } from './atlas-cache.js';
+export type { MSDFInitOptions, MSDFFontHandle, VariationAxis, MSDFMode, MSDFPixelFormat, MSDFPrecision, MSDFErrorCorrection, MSDFOutputLayout, MSDFFontMetrics, MSDFKerningPair, MSDFAtlas, MSDFAtlasChar, MSDFAtlasLevel, MSDFAtlasPyramid, MSDFStagingBuffer, MSDFIntoResult, MSDFCacheStats, MSDFStats, MSDFGlyphStats, MSDFAsyncOptions, MSDFStreamSlice, MSDFAtlasRect, MSDFAtlasUpdate, MSDFAtlasStreamOptions } from './msdf-generator.js';
+export type { MSDFWorkerMethod } from './msdf-worker.js';
+export type { MSDFAtlasFile, MSDFAtlasStore } from './atlas-cache.js';
@@ -1,5 +1,88 @@
-// @ts-ignore - Emscripten generated module, bundled by esbuild
-import LibMSDFFactory from '../build/libmsdf-core.js';
+import { parseAtlasFile, atlasKeyFromWords } from './atlas-cache.js';
+import type { MSDFAtlasFile, MSDFAtlasStore } from './atlas-cache.js';
+
+// Emscripten module factory plus the thread count to run it with (1 = single-threaded build).
+// Set by the bundle entry point (index.ts or index-mt.ts), which imports the matching build.
+// simdFactory is the glue of the SIMD128 variant, used when the runtime supports it.
+export interface LibMSDFBuild {
+    factory: (options: object) => Promise<any>;
+    simdFactory?: (options: object) => Promise<any>;
+    threads: number;
+}
+
+// Smallest module using a SIMD128 instruction (i8x16.splat + i8x16.popcnt);
+// validates only where WebAssembly SIMD is supported
+const SIMD_PROBE = new Uint8Array([
+    0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0, 10, 10, 1, 8, 0, 65, 0, 253, 15, 253, 98, 11
+]);
+
+// Bit 31 of a codepoint argument marks a glyph index (msdf_core::GLYPH_INDEX_FLAG)
+const GLYPH_INDEX_FLAG = 0x80000000;
+
+// Axis tag as 4 ASCII bytes in a uint32, first character in the low byte (set_variation_axes layout)
+function packTag(tag: string): number {
+    if (tag.length !== 4) {
+        throw new Error(`Axis tag must be 4 characters: "${tag}"`);
+    }
+    return (tag.charCodeAt(0) | (tag.charCodeAt(1) << 8) | (tag.charCodeAt(2) << 16) | (tag.charCodeAt(3) << 24)) >>> 0;
+}
+
+function simdSupported(): boolean {
+    try {
+        return typeof WebAssembly === 'object' && WebAssembly.validate(SIMD_PROBE);
+    } catch (e) {
+        return false;
+    }
+}
+
+// Compiled modules by path, shared by every init() / preload() in this realm
+const compiledModules = new Map<string, Promise<WebAssembly.Module>>();
+
+function isNodeFilePath(path: string): boolean {
+    const node = (globalThis as any).process?.versions?.node;
+    return !!node && !/^(https?|data|blob):/.test(path);
+}
+
+// Compile a .wasm file: streaming where the runtime can (compiles while downloading, and
+// lets browsers reuse their cached machine code), else from the whole file
+async function compileWasm(path: string): Promise<WebAssembly.Module> {
+    if (isNodeFilePath(path)) {
+        const fs = await import('fs/promises');
+        return WebAssembly.compile(await fs.readFile(path.startsWith('file:') ? new URL(path) : path));
+    }
+    if (typeof WebAssembly.compileStreaming === 'function') {
+        try {
+            return await WebAssembly.compileStreaming(fetch(path, { credentials: 'same-origin' }));
+        } catch (e) {
+            // Served without the application/wasm MIME type, most often: compile the bytes instead
+        }
+    }
+    const response = await fetch(path, { credentials: 'same-origin' });
+    if (!response.ok) throw new Error(`Failed to load ${path}: ${response.status}`);
+    return WebAssembly.compile(await response.arrayBuffer());
+}
+
+function compiledModule(path: string): Promise<WebAssembly.Module> {
+    let compiled = compiledModules.get(path);
+    if (!compiled) {
+        compiled = compileWasm(path);
+        compiledModules.set(path, compiled);
+        compiled.catch(() => compiledModules.delete(path)); // Let a later call retry
+    }
+    return compiled;
+}
+
+export interface MSDFInitOptions {
+    // SIMD128 module: a path, false to always use the baseline module, or unset (default)
+    // for modulePath with ".wasm" replaced by "-simd.wasm". Falls back to modulePath if it fails to load.
+    simdModulePath?: string | false;
+}
+
+let moduleBuild: LibMSDFBuild | null = null;
+
+export function setModuleBuild(build: LibMSDFBuild) {
+    moduleBuild = build;
+}
 
 export interface MSDFMetrics {
     width: number;
@@ -11,54 +94,552 @@ export interface MSDFMetrics {
 
 // Variation axis: 4-letter tag + value
 export interface VariationAxis {
-    tag: string;   // 4-letter tag: "wght", "opsz", "slnt", "ital", "wdth"
+    tag: string;   // 4-letter tag: "wght", "opsz", "slnt", "ital", "wdth" or a custom axis ("GRAD")
     value: number; // axis value
 }
 
+// Distance field type: 'msdf' = 3 channels (RGB), 'mtsdf' = 4 channels (RGBA), 'sdf' = 1 channel (R)
+export type MSDFMode = 'msdf' | 'mtsdf' | 'sdf';
+
+// Channels and WASM mode index (msdf_core::GlyphMode) of each mode
+const MODE_CHANNELS: Record<MSDFMode, number> = { msdf: 3, mtsdf: 4, sdf: 1 };
+const MODE_INDEX: Record<MSDFMode, number> = { msdf: 0, mtsdf: 1, sdf: 2 };
+
+// Output sample type: 'float32' = raw distance samples, 'uint8' = quantized in WASM (0..255, edge = 128)
+export type MSDFPixelFormat = 'float32' | 'uint8';
+
+// Rasterization precision: 'exact' = msdfgen defaults, 'fast' = see setPrecision()
+export type MSDFPrecision = 'exact' | 'fast';
+
+// Error correction policy of 'msdf' / 'mtsdf' output, see setErrorCorrection()
+export type MSDFErrorCorrection = 'default' | 'off' | 'edge-only' | 'full' | 'auto';
+
+// WASM policy index of each (msdf_core::ErrorCorrection)
+const CORRECTION_POLICIES: MSDFErrorCorrection[] = ['default', 'off', 'edge-only', 'full', 'auto'];
+
+// Memory layout of generated pixels, see setOutputLayout()
+export interface MSDFOutputLayout {
+    topDown?: boolean;      // Row 0 is the top row (default false: the bottom row, msdfgen's order)
+    rowAlignment?: number;  // Row starts are multiples of this many bytes: a power of two up to 4096 (default 1)
+    padToRGBA?: boolean;    // 'msdf' stored as RGBA with alpha 1.0 / 255 (default false: RGB)
+}
+
+// Largest MSDFOutputLayout.rowAlignment (msdf_core::LAYOUT_MAX_ROW_ALIGN)
+const MAX_ROW_ALIGNMENT = 4096;
+
 export interface MSDFGlyph {
     metrics: MSDFMetrics;
-    pixels: Float32Array; // RGB float data
+    pixels: Float32Array | Uint8Array; // Float32Array for 'float32', Uint8Array for 'uint8'; rowStride * height samples
+    channels: number;   // Per stored pixel: the mode's, or 4 for 'msdf' padded to RGBA
+    rowStride: number;  // Samples from one row to the next (width * channels unless rows are aligned)
+}
+
+// Font-wide line metrics (see getFontMetrics()); pixels at the requested size, y up like planeBounds
+export interface MSDFFontMetrics {
+    unitsPerEm: number;     // Font units per em (not scaled)
+    ascender: number;       // Baseline to top of the line, positive
+    descender: number;      // Baseline to bottom of the line, negative
+    lineHeight: number;     // Baseline to baseline
+    underlineY: number;     // Underline position, usually negative
+    underlineThickness: number;
+}
+
+// One kerned pair of getKerningTable()
+export interface MSDFKerningPair {
+    first: number;
+    second: number;
+    amount: number; // Pixels added to the first glyph's advance (negative = closer)
+}
+
+// One entry of an atlas char table (BMFont-style)
+export interface MSDFAtlasChar {
+    id: number;      // Unicode codepoint
+    x: number;       // Bitmap position in the page (pixels, page row order)
+    y: number;
+    width: number;   // Bitmap size (0 x 0 for empty glyphs such as space)
+    height: number;
+    xoffset: number; // Bitmap left edge relative to the pen position (pixels)
+    yoffset: number; // Bitmap top edge relative to the baseline, y up (pixels)
+    xadvance: number;
+}
+
+export interface MSDFAtlas {
+    width: number;
+    height: number;
+    channels: number;       // 1 for SDF, 3 for MSDF, 4 for MTSDF (or MSDF padded to RGBA)
+    rowStride: number;      // Samples from one row to the next (width * channels unless rows are aligned)
+    pixels: Float32Array | Uint8Array; // rowStride * height samples, row-major, bottom-to-top unless topDown
+    chars: MSDFAtlasChar[];
+    missing: number[];      // Codepoints that failed to load or did not fit in maxSize
+}
+
+// One size of an MSDFAtlasPyramid
+export interface MSDFAtlasLevel {
+    fontSize: number;
+    chars: MSDFAtlasChar[];
+    missing: number[];      // Codepoints that failed to load or did not fit at this size
+}
+
+// generateAtlasPyramid(): one page, one char table per size
+export interface MSDFAtlasPyramid {
+    width: number;
+    height: number;
+    channels: number;
+    rowStride: number;
+    pixels: Float32Array | Uint8Array; // Same layout as MSDFAtlas.pixels
+    levels: MSDFAtlasLevel[];          // In fontSizes order
+}
+
+/**
+ * Caller-owned pixel buffer in WASM memory (e.g., a texture staging area).
+ * Glyphs are rendered into it in place with generateInto(), with no copy through JS.
+ */
+export interface MSDFStagingBuffer {
+    readonly ptr: number;      // WASM address of the first sample
+    readonly width: number;    // Pixels
+    readonly height: number;
+    readonly mode: MSDFMode;
+    readonly format: MSDFPixelFormat;
+    readonly channels: number; // 1 for SDF, 3 for MSDF, 4 for MTSDF
+    // Live view over the buffer (width * height * channels samples, row-major, bottom-to-top).
+    // Re-fetch after other calls: WASM memory growth detaches previously returned views.
+    view(): Float32Array | Uint8Array;
+    // Release the WASM memory. The buffer must not be used afterwards.
+    free(): void;
+}
+
+// Result of generateInto(): written = false if the glyph does not fit the space left at (x, y)
+export interface MSDFIntoResult {
+    metrics: MSDFMetrics;
+    written: boolean;
+}
+
+// Glyph cache counters (see getCacheStats())
+export interface MSDFCacheStats {
+    hits: number;
+    misses: number;
+    evictions: number;
+    entries: number; // Glyphs currently cached
+    bytes: number;   // Pixel bytes currently cached
+    budget: number;  // Byte budget (0 = cache disabled)
+}
+
+// One instrumented glyph (see getStats()); times in microseconds
+export interface MSDFGlyphStats {
+    codepoint: number;
+    width: number;
+    height: number;
+    channels: number;
+    allocBytes: number;   // Scratch memory the glyph had to grow (0 once warmed up)
+    loadUs: number;       // FreeType outline load (0 if the outline was cached)
+    coloringUs: number;   // normalize + edge coloring (0 if the outline was cached)
+    rasterUs: number;     // Distance field generation
+    packUs: number;       // uint8 quantization, or the copy for glyph-cache hits
+    shapeCached: boolean;
+    glyphCached: boolean;
+    uint8: boolean;
+}
+
+// Instrumentation snapshot; enabled is false unless the module was built with STATS=1
+export interface MSDFStats {
+    enabled: boolean;
+    glyphs: number;           // Glyphs recorded since the last resetStats()
+    shapeCacheHits: number;
+    glyphCacheHits: number;
+    allocBytes: number;       // Per-glyph temporaries plus scratch buffer growth
+    loadMs: number;           // Stage totals since the last resetStats()
+    coloringMs: number;
+    rasterMs: number;
+    packMs: number;
+    records: MSDFGlyphStats[]; // Most recent glyphs, oldest first
+}
+
+// Handle of a font added with addFont() / addFontFrom() (the WASM font id)
+export type MSDFFontHandle = number;
+
+// Options of generateAsync() / streamCharset()
+export interface MSDFAsyncOptions {
+    mode?: MSDFMode;            // Default 'mtsdf'
+    format?: MSDFPixelFormat;   // Default 'float32'
+    priority?: number[];        // Codepoints to generate first (e.g., the visible text), in order
+    sliceMs?: number;           // Work per slice before yielding to the event loop (default 8)
+    signal?: AbortSignal;       // Stops at the next slice boundary
+}
+
+// Glyphs generated in one time slice by streamCharset(), in generation order
+export interface MSDFStreamSlice {
+    codepoints: number[];
+    glyphs: (MSDFGlyph | null)[];
+}
+
+// Region of an atlas page, in pixels and page row order (like MSDFAtlasChar)
+export interface MSDFAtlasRect {
+    x: number;
+    y: number;
+    width: number;
+    height: number;
+}
+
+// One glyph of streamAtlas(): the page region it now occupies, ready to upload
+export interface MSDFAtlasUpdate {
+    glyphId: number;                // Codepoint (or glyph index with bit 31) as requested
+    rect: MSDFAtlasRect | null;     // null if the glyph failed or the page is full; 0 x 0 for empty glyphs
+    char: MSDFAtlasChar | null;     // Char table entry, null with rect
+}
+
+// streamAtlas() options; mode and format are the page's
+export type MSDFAtlasStreamOptions = Omit<MSDFAsyncOptions, 'mode' | 'format'>;
+
+// Codepoints in generation order: listed priority ones first, then the rest as given, each once
+function generationOrder(codepoints: number[], priority: number[] = []): number[] {
+    const wanted = new Set(codepoints);
+    const seen = new Set<number>();
+    const order: number[] = [];
+    for (const code of [...priority, ...codepoints]) {
+        if (!wanted.has(code) || seen.has(code)) continue;
+        seen.add(code);
+        order.push(code);
+    }
+    return order;
+}
+
+// Resolve on a later task so input and rendering can run (scheduler.yield() where available)
+function yieldToEventLoop(): Promise<void> {
+    const scheduler = (globalThis as any).scheduler;
+    if (scheduler && typeof scheduler.yield === 'function') return scheduler.yield();
+    return new Promise(resolve => setTimeout(resolve, 0));
 }
 
 export class MSDFGenerator {
     private module: any;
     private fontLoaded: boolean = false;
-    private fontLen: number = 0;
+    private fontId: number = 0;                        // Current font
+    private fonts: Set<MSDFFontHandle> = new Set();    // Every open font
+    private replaceableFont: MSDFFontHandle = 0;       // Font of the last loadFont(), closed by the next one
+    private viewMode: boolean = false;
+    private layout: Required<MSDFOutputLayout> = { topDown: false, rowAlignment: 1, padToRGBA: false };
+    private simdModule: boolean;
 
-    private constructor(wasmModule: any) {
+    private constructor(wasmModule: any, simd: boolean) {
         this.module = wasmModule;
+        this.simdModule = simd;
+    }
+
+    // Copy count samples starting at a WASM pointer into a new JS array (or view them in view mode)
+    private copyPixels(ptr: number, count: number, format: MSDFPixelFormat): Float32Array | Uint8Array {
+        const heap = format === 'uint8' ? this.module.HEAPU8 : this.module.HEAPF32;
+        const offset = format === 'uint8' ? ptr : ptr >> 2;
+        if (this.viewMode) return heap.subarray(offset, offset + count);
+        return heap.slice(offset, offset + count);
+    }
+
+    // Stored channels and row stride (in samples) of width pixels of a mode in the current output layout
+    private outputRows(width: number, channels: number, format: MSDFPixelFormat): { channels: number, rowStride: number } {
+        const stored = this.layout.padToRGBA && channels === 3 ? 4 : channels;
+        const sampleBytes = format === 'uint8' ? 1 : 4;
+        const align = this.layout.rowAlignment;
+        const rowBytes = Math.ceil(width * stored * sampleBytes / align) * align;
+        return { channels: stored, rowStride: rowBytes / sampleBytes };
     }
 
     /**
      * Initialize the MSDF Generator.
+     * Where WebAssembly SIMD is available, the SIMD128 module (libMSDF-simd.wasm, next to
+     * libMSDF.wasm by default) is loaded instead; see the simd getter.
+     * Browsers compile the module while it downloads (served as application/wasm); a module
+     * compiled by an earlier init() or preload() with the same path is reused.
      * @param modulePath Path to the libMSDF.wasm file (URL in browser, file path in Node/Deno)
+     * @param options SIMD module selection
      */
-    static async init(modulePath: string): Promise<MSDFGenerator> {
-        const mod = await LibMSDFFactory({
-            locateFile: (filename: string) => {
-                if (filename.endsWith('.wasm')) return modulePath;
-                return filename;
+    static async init(modulePath: string, options: MSDFInitOptions = {}): Promise<MSDFGenerator> {
+        if (!moduleBuild) throw new Error("No libMSDF build registered");
+        const build = moduleBuild;
+        // The module is compiled here (once per path, see compiledModule()) and Emscripten only instantiates it
+        const load = (factory: (options: object) => Promise<any>, wasmPath: string) => {
+            let fail: (error: unknown) => void = () => {};
+            const failed = new Promise<never>((_, reject) => { fail = reject; });
+            return Promise.race([failed, factory({
+                locateFile: (filename: string) => {
+                    if (filename.endsWith('.wasm')) return wasmPath;
+                    return filename;
+                },
+                instantiateWasm: (imports: WebAssembly.Imports,
+                                  receive: (instance: WebAssembly.Instance, module: WebAssembly.Module) => void) => {
+                    compiledModule(wasmPath)
+                        .then(module => WebAssembly.instantiate(module, imports)
+                            .then(instance => receive(instance, module)))
+                        .catch(fail); // Emscripten does not see asynchronous failures
+                    return {};
+                }
+            })]);
+        };
+
+        let mod: any = null;
+        let simd = false;
+        const simdPath = MSDFGenerator.simdPath(build, modulePath, options);
+        if (simdPath) {
+            try {
+                mod = await load(build.simdFactory!, simdPath);
+                simd = true;
+            } catch (e) {
+                mod = null; // Not deployed or not loadable: use the baseline module
             }
-        });
-        return new MSDFGenerator(mod);
+        }
+        if (!mod) mod = await load(build.factory, modulePath);
+
+        if (build.threads > 1) mod._set_thread_count(build.threads);
+        return new MSDFGenerator(mod, simd);
+    }
+
+    /**
+     * Start downloading and compiling the module init() will load, e.g. while the font is
+     * still being fetched. init() with the same paths then only instantiates it.
+     * Compiled modules are kept for the lifetime of the page (or worker, or process).
+     * @param modulePath Path to the libMSDF.wasm file, as for init()
+     * @param options SIMD module selection, as for init()
+     */
+    static async preload(modulePath: string, options: MSDFInitOptions = {}): Promise<void> {
+        if (!moduleBuild) throw new Error("No libMSDF build registered");
+        const simdPath = MSDFGenerator.simdPath(moduleBuild, modulePath, options);
+        if (simdPath) {
+            try {
+                await compiledModule(simdPath);
+                return;
+            } catch (e) {
+                // init() falls back to the baseline module as well
+            }
+        }
+        await compiledModule(modulePath);
+    }
+
+    // The SIMD module init() tries first, or null if the baseline module is used directly
+    private static simdPath(build: LibMSDFBuild, modulePath: string, options: MSDFInitOptions): string | null {
+        const simdPath = options.simdModulePath ?? modulePath.replace(/\.wasm$/, '-simd.wasm');
+        return build.simdFactory && simdPath && simdPath !== modulePath && simdSupported() ? simdPath : null;
+    }
+
+    /**
+     * True if the SIMD128 module was loaded.
+     */
+    get simd(): boolean {
+        return this.simdModule;
+    }
+
+    /**
+     * Number of threads used by generateBatch() and generateAtlas().
+     * Always 1 for the single-threaded build (libMSDF.js).
+     */
+    get threadCount(): number {
+        return this.module._get_thread_count();
+    }
+
+    /**
+     * Current rasterization precision (see setPrecision()).
+     */
+    get precision(): MSDFPrecision {
+        return this.module._get_precision() === 1 ? 'fast' : 'exact';
+    }
+
+    /**
+     * Select the rasterization precision of every generate call.
+     * 'fast' skips msdfgen's contour overlap handling for outlines whose contours are
+     * disjoint or properly nested, and runs error correction without its exact distance
+     * checks. Outputs keep their size and metrics; samples can differ slightly near
+     * corners and where error correction would have stepped in.
+     * Glyph cache entries are kept per precision.
+     * @param precision 'exact' (default) or 'fast'
+     */
+    setPrecision(precision: MSDFPrecision): void {
+        this.module._set_precision(precision === 'fast' ? 1 : 0);
+    }
+
+    /**
+     * Current error correction policy (see setErrorCorrection()).
+     */
+    get errorCorrection(): MSDFErrorCorrection {
+        return CORRECTION_POLICIES[this.module._get_error_correction()] ?? 'default';
+    }
+
+    /**
+     * Select how every later 'msdf' / 'mtsdf' generate call runs msdfgen's error correction,
+     * its most expensive pass after the distances themselves.
+     * 'default' follows setPrecision(); 'off' skips the pass; 'edge-only' only treats texels
+     * next to edges, without distance checks (for interactive previews); 'full' checks every
+     * suspect texel against the exact distance (for baked atlases); 'auto' skips the pass for
+     * glyphs whose outlines have no corners and otherwise acts as 'default'.
+     * Glyph cache entries are kept per policy.
+     * @param policy Error correction policy ('default' to restore)
+     */
+    setErrorCorrection(policy: MSDFErrorCorrection): void {
+        const index = CORRECTION_POLICIES.indexOf(policy);
+        if (index < 0) throw new Error(`Unknown error correction policy: ${policy}`);
+        this.module._set_error_correction(index);
+    }
+
+    /**
+     * True if band-limited rasterization is enabled (see setSparseRaster()).
+     */
+    get sparseRaster(): boolean {
+        return this.module._get_sparse_raster() === 1;
+    }
+
+    /**
+     * Compute distances only near the outline.
+     * The frame is split into 8x8 tiles; tiles farther than the distance range from every
+     * edge are filled by an inside/outside test instead of per-pixel distances, so large
+     * glyphs cost in proportion to their outline rather than their area. 'sdf' output in
+     * 'uint8' is unchanged. MSDF / MTSDF samples can change where a channel's pseudo-distance
+     * along an edge extension is still unsaturated outside the band, and through error
+     * correction near them, so compare output for your fonts before enabling it. 'float32'
+     * samples outside the band are clamped to 0 / 1 instead of extrapolated. Glyph cache
+     * entries are kept per setting.
+     * @param enabled true for band-limited rasterization, false (default) for every pixel
+     */
+    setSparseRaster(enabled: boolean): void {
+        this.module._set_sparse_raster(enabled ? 1 : 0);
+    }
+
+    /**
+     * True if contour culling is enabled (see setEdgeGrid()).
+     */
+    get edgeGrid(): boolean {
+        return this.module._get_edge_grid() === 1;
     }
 
     /**
-     * Load a font into the shared WASM buffer.
+     * Cull contours per tile for complex glyphs.
+     * Outlines with three or more contours are rendered in 16x16 tiles, each evaluating only
+     * the contours that can hold a pixel's nearest edge, so glyphs like '%', '&' or CJK
+     * characters no longer test every edge at every pixel. Combines with setSparseRaster().
+     * Glyph cache entries are kept per setting.
+     * @param enabled true to cull, false (default) to test every contour
+     */
+    setEdgeGrid(enabled: boolean): void {
+        this.module._set_edge_grid(enabled ? 1 : 0);
+    }
+
+    /**
+     * Current output layout (see setOutputLayout()).
+     */
+    get outputLayout(): Required<MSDFOutputLayout> {
+        return { ...this.layout };
+    }
+
+    /**
+     * Select the memory layout of every later generate, generateBatch() and generateAtlas*()
+     * result, so pixels can go to a texture upload as they are: e.g.
+     * { topDown: true, rowAlignment: 256, padToRGBA: true } for WebGPU writeTexture() into an
+     * 'rgba8unorm' texture with bytesPerRow = rowStride. Pixels are written in this layout
+     * inside WASM; results report it in channels and rowStride. In a top-down atlas each
+     * char's y is the page row of its top edge. generateInto() and streamAtlas() keep the
+     * staging buffer's layout. Glyph cache entries and atlas cache keys are kept per layout.
+     * @param layout Fields to change; omitted fields keep their current value
+     */
+    setOutputLayout(layout: MSDFOutputLayout): void {
+        const next = { ...this.layout, ...layout };
+        const align = next.rowAlignment;
+        if (!Number.isInteger(align) || align < 1 || align > MAX_ROW_ALIGNMENT || (align & (align - 1)) !== 0) {
+            throw new Error(`Invalid row alignment: ${align}`);
+        }
+        this.module._set_output_layout(next.topDown ? 1 : 0, align, next.padToRGBA ? 1 : 0);
+        this.layout = next;
+    }
+
+    /**
+     * Return pixels as views into WASM memory instead of copies.
+     * Saves one copy per call, but a view is only valid until the next generate call
+     * (which reuses the scratch buffer) or until WASM memory grows (which detaches it).
+     * Upload or copy the pixels before calling into the generator again.
+     * @param enabled true for views, false (default) for owned copies
+     */
+    setViewMode(enabled: boolean): void {
+        this.viewMode = enabled;
+    }
+
+    /**
+     * Load a font and make it the current font. The font is parsed once in WASM and reused
+     * by every generate call until another font is loaded this way or the generator is disposed.
+     * Fonts added with addFont() stay open.
      * @param fontBytes Raw TTF/OTF bytes
      */
     loadFont(fontBytes: Uint8Array) {
-        this.fontLen = fontBytes.byteLength;
-        
-        // 1. Get pointer to persistent buffer
-        const ptr = this.module._prepare_font_buffer(this.fontLen);
-        
-        // 2. Copy data
-        this.module.HEAPU8.set(fontBytes, ptr);
-        
+        // Release the previous loadFont() session
+        if (this.replaceableFont !== 0) {
+            this.closeFont(this.replaceableFont);
+            this.replaceableFont = 0;
+        }
+        const handle = this.addFont(fontBytes);
+        this.useFont(handle);
+        this.replaceableFont = handle;
+    }
+
+    /**
+     * Add a font to the generator's registry without closing other fonts.
+     * Each font keeps its bytes, parsed face and outline cache in WASM until closeFont(),
+     * so switching between fonts with useFont() copies and parses nothing.
+     * The first font added becomes the current font.
+     * @param fontBytes Raw TTF/OTF bytes
+     * @returns Handle for useFont() / closeFont()
+     */
+    addFont(fontBytes: Uint8Array): MSDFFontHandle {
+        return this.addFontFrom(fontBytes.byteLength, view => view.set(fontBytes));
+    }
+
+    /**
+     * Add a font whose bytes are written straight into WASM memory, skipping the
+     * intermediate JS copy. fill receives a view of byteLength bytes in the WASM heap and
+     * must fill it synchronously (e.g. fs.readSync in Node); the view is not valid afterwards.
+     * @param byteLength Size of the font file in bytes
+     * @param fill Writes the font file into view
+     * @returns Handle for useFont() / closeFont()
+     */
+    addFontFrom(byteLength: number, fill: (view: Uint8Array) => void): MSDFFontHandle {
+        // 1. Get pointer to the font buffer; the session takes it over on open
+        const ptr = this.module._prepare_font_buffer(byteLength);
+
+        // 2. Caller writes the file in place
+        fill(this.module.HEAPU8.subarray(ptr, ptr + byteLength));
+
+        // 3. Parse the font
+        const fontId = this.module._open_font(byteLength);
+        if (fontId === 0) throw new Error("Failed to load font data");
+
+        this.fonts.add(fontId);
+        if (!this.fontLoaded) this.useFont(fontId);
+        return fontId;
+    }
+
+    /**
+     * Make a font from addFont() the target of every following call
+     * (generation, hasGlyph(), getCoverage()). Caches of all fonts are kept.
+     */
+    useFont(handle: MSDFFontHandle): void {
+        if (!this.fonts.has(handle)) throw new Error(`Unknown font handle: ${handle}`);
+        this.fontId = handle;
         this.fontLoaded = true;
     }
 
+    /**
+     * Close a font and free its bytes, face and cached glyphs. If it was the current
+     * font, no font is current until the next useFont() / loadFont().
+     */
+    closeFont(handle: MSDFFontHandle): void {
+        if (!this.fonts.delete(handle)) return;
+        this.module._close_font(handle);
+        if (this.replaceableFont === handle) this.replaceableFont = 0;
+        if (this.fontId === handle) {
+            this.fontLoaded = false;
+            this.fontId = 0;
+        }
+    }
+
+    /**
+     * Handle of the current font, or null if none is selected.
+     */
+    get currentFont(): MSDFFontHandle | null {
+        return this.fontLoaded ? this.fontId : null;
+    }
+
     /**
      * Check if a glyph exists in the font (without generating it).
      * @param charCode Unicode codepoint
@@ -66,37 +647,23 @@ export class MSDFGenerator {
      */
     hasGlyph(charCode: number): boolean {
         if (!this.fontLoaded) throw new Error("Font not loaded");
-        return this.module._has_glyph(this.fontLen, charCode) !== 0;
+        return this.module._has_glyph(this.fontId, charCode) !== 0;
     }
 
-    /**
-     * Generate a single glyph.
-     * @param charCode Unicode codepoint
-     * @param fontSize Target size in pixels
-     * @param pixelRange MSDF range (default 4.0)
-     */
-    generate(charCode: number, fontSize: number = 32, pixelRange: number = 4.0): MSDFGlyph | null {
+    // Shared body of the single glyph methods: call (with the metrics pointer) returns the pixel pointer
+    private generateSingle(call: (metricsPtr: number) => number, channels: number, charCode: number,
+                           format: MSDFPixelFormat): MSDFGlyph | null {
         if (!this.fontLoaded) throw new Error("Font not loaded");
 
-        // 1. Allocate Metrics Output Array (10 floats = 40 bytes)
+        // Metrics output array (10 floats = 40 bytes)
         const metricsPtr = this.module._malloc(40);
 
         try {
-            // 2. Call C++
-            const pixelsPtr = this.module._generate_glyph(
-                this.fontLen, 
-                charCode, 
-                fontSize, 
-                pixelRange, 
-                metricsPtr
-            );
+            const pixelsPtr = call(metricsPtr);
 
-            // 3. Read Metrics
-            // Float32 view of the metrics buffer
-            // HEAPF32 is divided by 4 (bytes per float)
-            const metricsOffset = metricsPtr >> 2; 
+            // HEAPF32 is indexed in floats (bytes / 4)
+            const metricsOffset = metricsPtr >> 2;
             const success = this.module.HEAPF32[metricsOffset + 0];
-            
             if (success === 0.0) return null;
 
             const width = this.module.HEAPF32[metricsOffset + 1];
@@ -106,214 +673,895 @@ export class MSDFGenerator {
             const b = this.module.HEAPF32[metricsOffset + 5];
             const r = this.module.HEAPF32[metricsOffset + 6];
             const t = this.module.HEAPF32[metricsOffset + 7];
-            // Atlas bounds (8,9) usually 0
+            // Atlas bounds (8,9) are 0 for single glyphs
 
-            // 4. Validate dimensions (empty shapes return 1x1)
+            // Empty shapes still return a padded bitmap
             if (width <= 0 || height <= 0 || width > 4096 || height > 4096) {
-                console.warn(`Invalid glyph dimensions: ${width}x${height}`);
+                console.warn(`Invalid glyph dimensions: ${width}x${height} for charCode ${charCode}`);
                 return null;
             }
 
-            // 5. Copy Pixels
-            const pixelCount = width * height * 3;
-            const pixels = new Float32Array(pixelCount);
-            const pixelsOffset = pixelsPtr >> 2;
-            
-            // Copy from WASM Heap to JS Array
-            pixels.set(
-                this.module.HEAPF32.subarray(pixelsOffset, pixelsOffset + pixelCount)
-            );
+            const rows = this.outputRows(width, channels, format);
+            const pixels = this.copyPixels(pixelsPtr, rows.rowStride * height, format);
 
             return {
-                metrics: {
-                    width, height, advance,
-                    planeBounds: { l, b, r, t },
-                    atlasBounds: { l: 0, b: 0 }
-                },
-                pixels
+                metrics: { width, height, advance, planeBounds: { l, b, r, t }, atlasBounds: { l: 0, b: 0 } },
+                pixels, channels: rows.channels, rowStride: rows.rowStride
             };
-
         } finally {
             this.module._free(metricsPtr);
         }
     }
 
+    /**
+     * Generate a single glyph.
+     * @param charCode Unicode codepoint
+     * @param fontSize Target size in pixels
+     * @param pixelRange MSDF range (default 4.0)
+     * @param format 'float32' (default) or 'uint8' (quantized in WASM, upload-ready)
+     */
+    generate(charCode: number, fontSize: number = 32, pixelRange: number = 4.0,
+             format: MSDFPixelFormat = 'float32'): MSDFGlyph | null {
+        return this.generateSingle(metricsPtr => this.module._generate_glyph(
+            this.fontId, charCode, fontSize, pixelRange, format === 'uint8' ? 1 : 0, metricsPtr
+        ), 3, charCode, format);
+    }
+
     /**
      * Generate a single MTSDF glyph (4 channels).
      * @param charCode Unicode codepoint
      * @param fontSize Target size in pixels
      * @param pixelRange MSDF range (default 4.0)
+     * @param format 'float32' (default) or 'uint8' (quantized in WASM, upload-ready)
+     */
+    generateMTSDF(charCode: number, fontSize: number = 32, pixelRange: number = 4.0,
+                  format: MSDFPixelFormat = 'float32'): MSDFGlyph | null {
+        return this.generateSingle(metricsPtr => this.module._generate_mtsdf_glyph(
+            this.fontId, charCode, fontSize, pixelRange, format === 'uint8' ? 1 : 0, metricsPtr
+        ), 4, charCode, format);
+    }
+
+    /**
+     * Generate a single-channel signed distance field with current variation axes.
+     * A true SDF has rounded corners when magnified, but costs a quarter of MTSDF's
+     * memory: enough for shadows, glows and small text.
+     * @param charCode Unicode codepoint
+     * @param fontSize Target size in pixels
+     * @param pixelRange Distance range (default 4.0)
+     * @param format 'float32' (default) or 'uint8' (R8 texture data)
+     */
+    generateSDF(charCode: number, fontSize: number = 32, pixelRange: number = 4.0,
+                format: MSDFPixelFormat = 'float32'): MSDFGlyph | null {
+        return this.generateSingle(metricsPtr => this.module._generate_glyph_mode(
+            this.fontId, MODE_INDEX.sdf, charCode, fontSize, pixelRange, format === 'uint8' ? 1 : 0, metricsPtr
+        ), 1, charCode, format);
+    }
+
+    /**
+     * Set variation axes for subsequent generate calls.
+     * Standard axes: wght (Weight), wdth (Width), opsz (Optical Size), ital (Italic), slnt (Slant);
+     * any other axis of the font (e.g. GRAD) by its tag. Unknown tags are ignored.
+     * Values are snapped to the steps set with setVariationStep(). Switching instances is cheap:
+     * FreeType is only touched when an outline of the new instance is not cached yet.
+     * @param axes Array of {tag, value} pairs
+     */
+    setVariationAxes(axes: VariationAxis[]): void {
+        const count = axes.length;
+        if (count === 0) {
+            this.module._clear_variation_axes();
+            return;
+        }
+        // One allocation: values (8 bytes each, first for alignment) + packed tags (4 bytes each)
+        const valuesPtr = this.module._malloc(count * 12);
+        const tagsPtr = valuesPtr + count * 8;
+        try {
+            for (let i = 0; i < count; i++) {
+                this.module.HEAPF64[(valuesPtr >> 3) + i] = axes[i].value;
+                this.module.HEAPU32[(tagsPtr >> 2) + i] = packTag(axes[i].tag);
+            }
+            this.module._set_variation_axes(tagsPtr, valuesPtr, count);
+        } finally {
+            this.module._free(valuesPtr);
+        }
+    }
+
+    /**
+     * Quantize variation axis values to multiples of step, so an animated axis (e.g. a
+     * weight slider) revisits a finite set of instances whose outlines and glyphs stay
+     * cached instead of generating a new instance every frame.
+     * Applies to axes set afterwards.
+     * @param step Step in axis units (e.g. 10 for wght); 0 (default) keeps values exact
+     * @param tag Axis to configure; omit to set the step of every axis without its own
+     */
+    setVariationStep(step: number, tag?: string): void {
+        this.module._set_variation_step(tag === undefined ? 0 : packTag(tag), step);
+    }
+
+    /**
+     * Set how many parsed outlines each loaded font keeps, across all variation
+     * instances (default 4096). Raise it when animating axes over many instances.
+     * @param outlines Maximum number of outlines; 0 disables outline reuse
+     */
+    setOutlineCacheCapacity(outlines: number): void {
+        this.module._set_outline_cache_capacity(outlines);
+    }
+
+    /**
+     * Clear variation axes (use font defaults).
+     */
+    clearVariationAxes(): void {
+        this.module._clear_variation_axes();
+    }
+
+    /**
+     * Generate MSDF glyph with current variation axes (3 channels).
+     */
+    generateVar(charCode: number, fontSize: number = 32, pixelRange: number = 4.0,
+                format: MSDFPixelFormat = 'float32'): MSDFGlyph | null {
+        return this.generateSingle(metricsPtr => this.module._generate_glyph_var(
+            this.fontId, charCode, fontSize, pixelRange, format === 'uint8' ? 1 : 0, metricsPtr
+        ), 3, charCode, format);
+    }
+
+    /**
+     * Generate MTSDF glyph with current variation axes (4 channels).
      */
-    generateMTSDF(charCode: number, fontSize: number = 32, pixelRange: number = 4.0): MSDFGlyph | null {
+    generateMTSDFVar(charCode: number, fontSize: number = 32, pixelRange: number = 4.0,
+                     format: MSDFPixelFormat = 'float32'): MSDFGlyph | null {
+        return this.generateSingle(metricsPtr => this.module._generate_mtsdf_glyph_var(
+            this.fontId, charCode, fontSize, pixelRange, format === 'uint8' ? 1 : 0, metricsPtr
+        ), 4, charCode, format);
+    }
+
+    /**
+     * Generate many glyphs with a single call into WASM.
+     * Uses the current variation axes (call clearVariationAxes() for font defaults).
+     * @param codepoints Unicode codepoints to generate
+     * @param fontSize Target size in pixels
+     * @param pixelRange MSDF range (default 4.0)
+     * @param mode 'msdf' (3 channels), 'mtsdf' (4 channels, default) or 'sdf' (1 channel)
+     * @param format 'float32' (default) or 'uint8'
+     * @returns One entry per codepoint, in input order; null where generation failed
+     */
+    generateBatch(codepoints: number[], fontSize: number = 32, pixelRange: number = 4.0,
+                  mode: MSDFMode = 'mtsdf', format: MSDFPixelFormat = 'float32'): (MSDFGlyph | null)[] {
         if (!this.fontLoaded) throw new Error("Font not loaded");
 
-        // 1. Allocate Metrics Output Array (10 floats = 40 bytes)
-        const metricsPtr = this.module._malloc(40);
+        const count = codepoints.length;
+        if (count === 0) return [];
+        const channels = MODE_CHANNELS[mode];
+
+        // One allocation for input codepoints (4 bytes each) + metrics table (40 bytes each)
+        const codepointsPtr = this.module._malloc(count * 44);
+        const metricsPtr = codepointsPtr + count * 4;
 
         try {
-            // 2. Call C++
-            const pixelsPtr = this.module._generate_mtsdf_glyph(
-                this.fontLen, 
-                charCode, 
-                fontSize, 
-                pixelRange, 
-                metricsPtr
+            this.module.HEAPU32.set(codepoints, codepointsPtr >> 2);
+
+            const pixelsPtr = this.module._generate_batch(
+                this.fontId, codepointsPtr, count, fontSize, pixelRange,
+                MODE_INDEX[mode], format === 'uint8' ? 1 : 0, metricsPtr
             );
 
-            // 3. Read Metrics
-            const metricsOffset = metricsPtr >> 2; 
-            const success = this.module.HEAPF32[metricsOffset + 0];
-            
-            if (success === 0.0) return null;
+            const heap = this.module.HEAPF32;
+            const sampleBytes = format === 'uint8' ? 1 : 4;
+            const results: (MSDFGlyph | null)[] = [];
+            let pixelsOffset = pixelsPtr;
 
-            const width = this.module.HEAPF32[metricsOffset + 1];
-            const height = this.module.HEAPF32[metricsOffset + 2];
-            const advance = this.module.HEAPF32[metricsOffset + 3];
-            const l = this.module.HEAPF32[metricsOffset + 4];
-            const b = this.module.HEAPF32[metricsOffset + 5];
-            const r = this.module.HEAPF32[metricsOffset + 6];
-            const t = this.module.HEAPF32[metricsOffset + 7];
+            for (let i = 0; i < count; i++) {
+                const m = (metricsPtr >> 2) + i * 10;
+                if (pixelsPtr === 0 || heap[m] === 0.0) {
+                    results.push(null);
+                    continue;
+                }
 
-            // 4. Validate dimensions (empty shapes return 1x1)
-            if (width <= 0 || height <= 0 || width > 4096 || height > 4096) {
-                console.warn(`Invalid glyph dimensions: ${width}x${height} for charCode ${charCode}`);
-                return null;
+                const width = heap[m + 1];
+                const height = heap[m + 2];
+                const rows = this.outputRows(width, channels, format);
+                const pixelCount = rows.rowStride * height;
+                const start = pixelsOffset;
+                pixelsOffset += pixelCount * sampleBytes;
+
+                if (width <= 0 || height <= 0 || width > 4096 || height > 4096) {
+                    console.warn(`Invalid glyph dimensions: ${width}x${height} for charCode ${codepoints[i]}`);
+                    results.push(null);
+                    continue;
+                }
+
+                results.push({
+                    metrics: {
+                        width, height, advance: heap[m + 3],
+                        planeBounds: { l: heap[m + 4], b: heap[m + 5], r: heap[m + 6], t: heap[m + 7] },
+                        atlasBounds: { l: 0, b: 0 }
+                    },
+                    pixels: this.copyPixels(start, pixelCount, format),
+                    channels: rows.channels, rowStride: rows.rowStride
+                });
             }
+            return results;
+        } finally {
+            this.module._free(codepointsPtr);
+        }
+    }
 
-            // 5. Copy Pixels (4 channels)
-            const pixelCount = width * height * 4;
-            const pixels = new Float32Array(pixelCount);
-            const pixelsOffset = pixelsPtr >> 2;
 
-            pixels.set(
-                this.module.HEAPF32.subarray(pixelsOffset, pixelsOffset + pixelCount)
-            );
+    /**
+     * Generate glyphs by glyph index instead of codepoint, e.g. for shaped text
+     * (HarfBuzz and other shapers output glyph ids); the cmap is skipped entirely.
+     * Same output and caching as generateBatch(), with the current variation axes.
+     * @param glyphIndices Glyph indices of the loaded font
+     * @returns One entry per index, in input order; null where generation failed
+     */
+    generateBatchByGlyphIndex(glyphIndices: number[], fontSize: number = 32, pixelRange: number = 4.0,
+                              mode: MSDFMode = 'mtsdf', format: MSDFPixelFormat = 'float32'): (MSDFGlyph | null)[] {
+        return this.generateBatch(glyphIndices.map(index => (index | GLYPH_INDEX_FLAG) >>> 0),
+                                  fontSize, pixelRange, mode, format);
+    }
 
-            return {
-                metrics: {
-                    width, height, advance,
-                    planeBounds: { l, b, r, t },
+    /**
+     * Generate one glyph by glyph index (see generateBatchByGlyphIndex()).
+     */
+    generateByGlyphIndex(glyphIndex: number, fontSize: number = 32, pixelRange: number = 4.0,
+                         mode: MSDFMode = 'mtsdf', format: MSDFPixelFormat = 'float32'): MSDFGlyph | null {
+        return this.generateBatchByGlyphIndex([glyphIndex], fontSize, pixelRange, mode, format)[0];
+    }
+
+    /**
+     * Metrics of many glyphs without rasterizing them, e.g. to lay out text or pack an atlas
+     * before (or instead of) generating the bitmaps. Identical to the metrics generate calls
+     * return for the same arguments and variation axes; mode and format do not change them.
+     * Outlines not cached yet are only loaded and bounded, and are not kept.
+     * @param codepoints Unicode codepoints (or glyph indices with bit 31 set)
+     * @param fontSize Target size in pixels
+     * @param pixelRange MSDF range (default 4.0)
+     * @returns One entry per codepoint, in input order; null where the glyph failed to load
+     */
+    measureGlyphs(codepoints: number[], fontSize: number = 32, pixelRange: number = 4.0): (MSDFMetrics | null)[] {
+        if (!this.fontLoaded) throw new Error("Font not loaded");
+        const count = codepoints.length;
+        if (count === 0) return [];
+
+        // One allocation for input codepoints (4 bytes each) + metrics table (40 bytes each)
+        const codepointsPtr = this.module._malloc(count * 44);
+        const metricsPtr = codepointsPtr + count * 4;
+        try {
+            this.module.HEAPU32.set(codepoints, codepointsPtr >> 2);
+            this.module._measure_glyphs(this.fontId, codepointsPtr, count, fontSize, pixelRange, metricsPtr);
+            const heap = this.module.HEAPF32;
+            const results: (MSDFMetrics | null)[] = [];
+            for (let i = 0; i < count; i++) {
+                const m = (metricsPtr >> 2) + i * 10;
+                if (heap[m] === 0.0) {
+                    results.push(null);
+                    continue;
+                }
+                results.push({
+                    width: heap[m + 1], height: heap[m + 2], advance: heap[m + 3],
+                    planeBounds: { l: heap[m + 4], b: heap[m + 5], r: heap[m + 6], t: heap[m + 7] },
                     atlasBounds: { l: 0, b: 0 }
-                },
-                pixels
-            };
+                });
+            }
+            return results;
+        } finally {
+            this.module._free(codepointsPtr);
+        }
+    }
 
+    /**
+     * Generate a charset in time slices, yielding to the event loop between them so a
+     * warm-up does not block the UI. Each slice is one or more generateBatch() calls sized
+     * to fill about sliceMs. Priority codepoints come first.
+     * The font current at the call is used throughout, with the variation axes current at
+     * each slice. Pixels are always copies, even in view mode. Stops early if the font is
+     * closed or the signal aborts.
+     * @param codepoints Unicode codepoints to generate (duplicates are generated once)
+     * @param fontSize Target size in pixels
+     * @param pixelRange MSDF range (default 4.0)
+     */
+    async *streamCharset(codepoints: number[], fontSize: number = 32, pixelRange: number = 4.0,
+                         options: MSDFAsyncOptions = {}): AsyncGenerator<MSDFStreamSlice> {
+        if (!this.fontLoaded) throw new Error("Font not loaded");
+        const font = this.fontId;
+        const mode = options.mode ?? 'mtsdf';
+        const format = options.format ?? 'float32';
+        const order = generationOrder(codepoints, options.priority);
+        const run = (codes: number[]) => this.batchFor(font, codes, fontSize, pixelRange, mode, format);
+        for await (const slice of this.timeSlices(font, order, options, run)) {
+            yield { codepoints: slice.codes, glyphs: slice.results };
+        }
+    }
+
+    /**
+     * Fill an atlas page progressively: glyphs are packed and rendered a time slice at a
+     * time (priority codepoints first), and each one is reported as soon as its region of
+     * the page is final, so it can be uploaded (texSubImage2D / writeTexture from
+     * page.view()) while the rest is still generating. Regions never move once reported.
+     *
+     * The page is a staging buffer from createStagingBuffer() and sets mode and format; it
+     * keeps its size, so glyphs that no longer fit are reported with rect = null. Packing
+     * follows the generation order and is looser than generateAtlas(). The page must not be
+     * freed while the stream runs. Font and slicing behave as in streamCharset().
+     * @param page Zeroed staging buffer to pack into (e.g., 1024 x 1024)
+     * @param codepoints Unicode codepoints to add (duplicates are added once)
+     */
+    async *streamAtlas(page: MSDFStagingBuffer, codepoints: number[], fontSize: number = 32, pixelRange: number = 4.0,
+                       options: MSDFAtlasStreamOptions = {}): AsyncGenerator<MSDFAtlasUpdate> {
+        if (!this.fontLoaded) throw new Error("Font not loaded");
+        const font = this.fontId;
+        const stream = this.module._open_atlas_stream(page.ptr, page.width, page.height, MODE_INDEX[page.mode],
+                                                      page.format === 'uint8' ? 1 : 0);
+        if (stream === 0) throw new Error("Invalid atlas page");
+        try {
+            const order = generationOrder(codepoints, options.priority);
+            const run = (codes: number[]) => this.addToAtlas(stream, font, codes, fontSize, pixelRange);
+            for await (const slice of this.timeSlices(font, order, options, run)) {
+                yield* slice.results;
+            }
         } finally {
-            this.module._free(metricsPtr);
+            this.module._close_atlas_stream(stream);
         }
     }
 
     /**
-     * Set variation axes for subsequent generate calls.
-     * Standard axes: wght (Weight), wdth (Width), opsz (Optical Size), ital (Italic), slnt (Slant)
-     * @param axes Array of {tag, value} pairs
+     * streamCharset() collected into one result: resolves with one entry per codepoint,
+     * in input order (null where generation failed). Rejects if the signal aborts.
      */
-    setVariationAxes(axes: VariationAxis[]): void {
-        this.module._clear_variation_axes();
-        for (const axis of axes) {
-            if (axis.tag.length !== 4) {
-                throw new Error(`Axis tag must be 4 characters: "${axis.tag}"`);
+    async generateAsync(codepoints: number[], fontSize: number = 32, pixelRange: number = 4.0,
+                        options: MSDFAsyncOptions = {}): Promise<(MSDFGlyph | null)[]> {
+        const byCode = new Map<number, MSDFGlyph | null>();
+        for await (const slice of this.streamCharset(codepoints, fontSize, pixelRange, options)) {
+            slice.codepoints.forEach((code, i) => byCode.set(code, slice.glyphs[i]));
+        }
+        if (options.signal?.aborted) throw options.signal.reason ?? new Error("Aborted");
+        return codepoints.map(code => byCode.get(code) ?? null);
+    }
+
+    /**
+     * Run order in batches through run, sized to fill about sliceMs, and yield each slice
+     * before giving the event loop a turn. Stops early if the font is closed or the signal aborts.
+     */
+    private async *timeSlices<T>(font: MSDFFontHandle, order: number[], options: MSDFAtlasStreamOptions,
+                                 run: (codes: number[]) => T[]): AsyncGenerator<{ codes: number[], results: T[] }> {
+        const sliceMs = options.sliceMs ?? 8;
+        let next = 0;
+        let chunk = 1; // Batch size, adapted to the measured cost per glyph
+        while (next < order.length) {
+            if (options.signal?.aborted || !this.fonts.has(font)) return;
+            const slice = { codes: [] as number[], results: [] as T[] };
+            const sliceStart = performance.now();
+            while (next < order.length) {
+                const codes = order.slice(next, next + chunk);
+                const batchStart = performance.now();
+                const results = run(codes);
+                const now = performance.now();
+                slice.codes.push(...codes);
+                slice.results.push(...results);
+                next += codes.length;
+
+                const left = sliceMs - (now - sliceStart);
+                if (left <= 0) break;
+                const perGlyph = Math.max(now - batchStart, 0.01) / codes.length;
+                chunk = Math.max(1, Math.min(256, Math.floor(left / perGlyph)));
             }
-            // Allocate string in WASM memory
-            const tagPtr = this.module._malloc(5);
-            for (let i = 0; i < 4; i++) {
-                this.module.HEAPU8[tagPtr + i] = axis.tag.charCodeAt(i);
+            yield slice;
+            if (next < order.length) await yieldToEventLoop();
+        }
+    }
+
+    // One atlas_stream_add() call: pack and render codes into a stream's page
+    private addToAtlas(stream: number, font: MSDFFontHandle, codes: number[], fontSize: number,
+                       pixelRange: number): MSDFAtlasUpdate[] {
+        // One allocation: codepoints (4 bytes each) + char table (32 bytes each)
+        const codepointsPtr = this.module._malloc(codes.length * 36);
+        const charsPtr = codepointsPtr + codes.length * 4;
+        try {
+            this.module.HEAPU32.set(codes, codepointsPtr >> 2);
+            this.module._atlas_stream_add(stream, font, codepointsPtr, codes.length, fontSize, pixelRange, charsPtr);
+            const heap = this.module.HEAPF32;
+            return codes.map((glyphId, i) => {
+                const c = (charsPtr >> 2) + i * 8;
+                if (heap[c] === 0.0) return { glyphId, rect: null, char: null };
+                const char: MSDFAtlasChar = {
+                    id: glyphId,
+                    x: heap[c + 1], y: heap[c + 2],
+                    width: heap[c + 3], height: heap[c + 4],
+                    xoffset: heap[c + 5], yoffset: heap[c + 6],
+                    xadvance: heap[c + 7]
+                };
+                return { glyphId, rect: { x: char.x, y: char.y, width: char.width, height: char.height }, char };
+            });
+        } finally {
+            this.module._free(codepointsPtr);
+        }
+    }
+
+    // generateBatch() on a given font, with copied pixels, leaving the current font and view mode as they were
+    private batchFor(font: MSDFFontHandle, codes: number[], fontSize: number, pixelRange: number,
+                     mode: MSDFMode, format: MSDFPixelFormat): (MSDFGlyph | null)[] {
+        const current = this.fontId;
+        const viewMode = this.viewMode;
+        this.fontId = font;
+        this.viewMode = false;
+        try {
+            return this.generateBatch(codes, fontSize, pixelRange, mode, format);
+        } finally {
+            this.fontId = current;
+            this.viewMode = viewMode;
+        }
+    }
+
+    /**
+     * Look up many codepoints in the font's cmap with one call into WASM,
+     * e.g. to resolve fallback fonts for a whole paragraph.
+     * @param codepoints Unicode codepoints
+     * @returns Glyph index per codepoint, in input order; 0 where the font has no glyph
+     */
+    getCoverage(codepoints: number[]): Uint32Array {
+        if (!this.fontLoaded) throw new Error("Font not loaded");
+        const count = codepoints.length;
+        const result = new Uint32Array(count);
+        if (count === 0) return result;
+
+        // One allocation: input codepoints + output indices (4 bytes each)
+        const codepointsPtr = this.module._malloc(count * 8);
+        const indicesPtr = codepointsPtr + count * 4;
+        try {
+            this.module.HEAPU32.set(codepoints, codepointsPtr >> 2);
+            this.module._get_coverage(this.fontId, codepointsPtr, count, indicesPtr);
+            result.set(this.module.HEAPU32.subarray(indicesPtr >> 2, (indicesPtr >> 2) + count));
+        } finally {
+            this.module._free(codepointsPtr);
+        }
+        return result;
+    }
+
+    /**
+     * Font-wide line metrics, read from the open font (no second font parser needed).
+     * Uses the current variation axes, which may move the line metrics of variable fonts.
+     * @param fontSize Size in pixels the metrics are scaled to (1 for em units)
+     */
+    getFontMetrics(fontSize: number = 32): MSDFFontMetrics {
+        if (!this.fontLoaded) throw new Error("Font not loaded");
+        const metricsPtr = this.module._malloc(6 * 4);
+        try {
+            if (!this.module._get_font_metrics(this.fontId, fontSize, metricsPtr)) {
+                throw new Error("Font has no line metrics");
             }
-            this.module.HEAPU8[tagPtr + 4] = 0; // null terminator
-            this.module._add_variation_axis(tagPtr, axis.value);
-            this.module._free(tagPtr);
+            const m = this.module.HEAPF32.subarray(metricsPtr >> 2, (metricsPtr >> 2) + 6);
+            return {
+                unitsPerEm: m[0], ascender: m[1], descender: m[2],
+                lineHeight: m[3], underlineY: m[4], underlineThickness: m[5]
+            };
+        } finally {
+            this.module._free(metricsPtr);
         }
     }
 
     /**
-     * Clear variation axes (use font defaults).
+     * Kerning of many pairs with one call into WASM: GPOS 'kern' lookups, or the legacy
+     * 'kern' table for fonts without them. Values are the font's default instance.
+     * @param pairs [first, second] codepoints (or glyph indices from getCoverage, with bit 31 set)
+     * @param fontSize Size in pixels
+     * @returns Pixels to add to the first glyph's advance, per pair in input order (0 = not kerned)
      */
-    clearVariationAxes(): void {
-        this.module._clear_variation_axes();
+    getKerning(pairs: [number, number][], fontSize: number = 32): Float32Array {
+        if (!this.fontLoaded) throw new Error("Font not loaded");
+        const count = pairs.length;
+        const result = new Float32Array(count);
+        if (count === 0) return result;
+
+        // One allocation: input pairs (8 bytes each) + output amounts (4 bytes each)
+        const pairsPtr = this.module._malloc(count * 12);
+        const amountsPtr = pairsPtr + count * 8;
+        try {
+            for (let i = 0; i < count; i++) {
+                this.module.HEAPU32[(pairsPtr >> 2) + i * 2] = pairs[i][0];
+                this.module.HEAPU32[(pairsPtr >> 2) + i * 2 + 1] = pairs[i][1];
+            }
+            this.module._get_kerning(this.fontId, pairsPtr, count, fontSize, amountsPtr);
+            result.set(this.module.HEAPF32.subarray(amountsPtr >> 2, (amountsPtr >> 2) + count));
+        } finally {
+            this.module._free(pairsPtr);
+        }
+        return result;
     }
 
     /**
-     * Generate MSDF glyph with current variation axes (3 channels).
+     * Every kerned ordered pair of a charset (e.g. the kernings block of a BMFont file).
+     * @param codepoints Unicode codepoints (or glyph indices with bit 31 set)
+     * @param fontSize Size in pixels
+     * @returns Kerned pairs only, grouped by first codepoint in input order
      */
-    generateVar(charCode: number, fontSize: number = 32, pixelRange: number = 4.0): MSDFGlyph | null {
+    getKerningTable(codepoints: number[], fontSize: number = 32): MSDFKerningPair[] {
         if (!this.fontLoaded) throw new Error("Font not loaded");
+        const count = codepoints.length;
+        if (count === 0) return [];
 
-        const metricsPtr = this.module._malloc(40);
+        // Room for a typical table first; a second call only if the charset kerns more pairs than that
+        let maxPairs = Math.min(count * count, 4096);
+        for (;;) {
+            // One allocation: codepoints (4 bytes each) + pairs (8 bytes each) + amounts (4 bytes each)
+            const codepointsPtr = this.module._malloc(count * 4 + maxPairs * 12);
+            const pairsPtr = codepointsPtr + count * 4;
+            const amountsPtr = pairsPtr + maxPairs * 8;
+            try {
+                this.module.HEAPU32.set(codepoints, codepointsPtr >> 2);
+                const total = this.module._get_kerning_table(
+                    this.fontId, codepointsPtr, count, fontSize, pairsPtr, amountsPtr, maxPairs
+                );
+                if (total > maxPairs) {
+                    maxPairs = total;
+                    continue;
+                }
+                const result: MSDFKerningPair[] = [];
+                for (let i = 0; i < total; i++) {
+                    result.push({
+                        first: this.module.HEAPU32[(pairsPtr >> 2) + i * 2],
+                        second: this.module.HEAPU32[(pairsPtr >> 2) + i * 2 + 1],
+                        amount: this.module.HEAPF32[(amountsPtr >> 2) + i]
+                    });
+                }
+                return result;
+            } finally {
+                this.module._free(codepointsPtr);
+            }
+        }
+    }
+
+    /**
+     * Pack a charset into one atlas page, rendering every glyph directly into its slot.
+     * Uses the current variation axes (call clearVariationAxes() for font defaults).
+     * @param codepoints Unicode codepoints to include
+     * @param fontSize Target size in pixels
+     * @param pixelRange MSDF range (default 4.0)
+     * @param maxSize Maximum page width/height in pixels (default 2048)
+     * @param mode 'msdf' (3 channels), 'mtsdf' (4 channels, default) or 'sdf' (1 channel)
+     * @param format 'float32' (default) or 'uint8' (upload-ready RGB8 / RGBA8 page)
+     * @returns The atlas, or null if no glyph could be generated
+     */
+    generateAtlas(codepoints: number[], fontSize: number = 32, pixelRange: number = 4.0,
+                  maxSize: number = 2048, mode: MSDFMode = 'mtsdf',
+                  format: MSDFPixelFormat = 'float32'): MSDFAtlas | null {
+        if (!this.fontLoaded) throw new Error("Font not loaded");
+
+        const count = codepoints.length;
+        if (count === 0) return null;
+        const channels = MODE_CHANNELS[mode];
+
+        // One allocation: codepoints (4 bytes each) + char table (32 bytes each) + page size (8 bytes)
+        const codepointsPtr = this.module._malloc(count * 36 + 8);
+        const charsPtr = codepointsPtr + count * 4;
+        const sizePtr = charsPtr + count * 32;
 
         try {
-            const pixelsPtr = this.module._generate_glyph_var(
-                this.fontLen, charCode, fontSize, pixelRange, metricsPtr
+            this.module.HEAPU32.set(codepoints, codepointsPtr >> 2);
+
+            const pixelsPtr = this.module._generate_atlas(
+                this.fontId, codepointsPtr, count, fontSize, pixelRange,
+                MODE_INDEX[mode], format === 'uint8' ? 1 : 0, maxSize, charsPtr, sizePtr
             );
+            if (pixelsPtr === 0) return null;
 
-            const metricsOffset = metricsPtr >> 2;
-            const success = this.module.HEAPF32[metricsOffset + 0];
-            if (success === 0.0) return null;
+            const width = this.module.HEAPU32[sizePtr >> 2];
+            const height = this.module.HEAPU32[(sizePtr >> 2) + 1];
+            const { chars, missing } = this.readAtlasChars(charsPtr, codepoints);
 
-            const width = this.module.HEAPF32[metricsOffset + 1];
-            const height = this.module.HEAPF32[metricsOffset + 2];
-            const advance = this.module.HEAPF32[metricsOffset + 3];
-            const l = this.module.HEAPF32[metricsOffset + 4];
-            const b = this.module.HEAPF32[metricsOffset + 5];
-            const r = this.module.HEAPF32[metricsOffset + 6];
-            const t = this.module.HEAPF32[metricsOffset + 7];
+            const rows = this.outputRows(width, channels, format);
+            return {
+                width, height, channels: rows.channels, rowStride: rows.rowStride,
+                pixels: this.copyPixels(pixelsPtr, rows.rowStride * height, format),
+                chars, missing
+            };
+        } finally {
+            this.module._free(codepointsPtr);
+        }
+    }
 
-            if (width <= 0 || height <= 0 || width > 4096 || height > 4096) {
-                console.warn(`Invalid glyph dimensions: ${width}x${height} for charCode ${charCode}`);
-                return null;
-            }
+    /**
+     * One atlas page holding a charset at several sizes, e.g. a mip chain [128, 64, 32]: with
+     * one pixelRange for all levels the distance range is the same in texels at every level,
+     * so a shader can pick the level closest to the on-screen size and keep the same edge
+     * smoothing. Each glyph is loaded and edge-colored once for all levels; only rasterization
+     * is repeated. Same packing, layout and variation axes as generateAtlas().
+     * @param codepoints Unicode codepoints to include at every size
+     * @param fontSizes Sizes in pixels, one level each, in the order given
+     * @returns The page and one char table per level, or null if no glyph could be generated
+     */
+    generateAtlasPyramid(codepoints: number[], fontSizes: number[], pixelRange: number = 4.0,
+                         maxSize: number = 2048, mode: MSDFMode = 'mtsdf',
+                         format: MSDFPixelFormat = 'float32'): MSDFAtlasPyramid | null {
+        if (!this.fontLoaded) throw new Error("Font not loaded");
+
+        const count = codepoints.length;
+        const levels = fontSizes.length;
+        if (count === 0 || levels === 0) return null;
+
+        // One allocation: sizes (8 bytes each, first for alignment) + codepoints (4 bytes each)
+        // + char table (32 bytes per glyph and level) + page size (8 bytes)
+        const sizesPtr = this.module._malloc(levels * 8 + count * 4 + count * levels * 32 + 8);
+        const codepointsPtr = sizesPtr + levels * 8;
+        const charsPtr = codepointsPtr + count * 4;
+        const sizePtr = charsPtr + count * levels * 32;
 
-            const pixelCount = width * height * 3;
-            const pixels = new Float32Array(pixelCount);
-            const pixelsOffset = pixelsPtr >> 2;
-            pixels.set(this.module.HEAPF32.subarray(pixelsOffset, pixelsOffset + pixelCount));
+        try {
+            this.module.HEAPF64.set(fontSizes, sizesPtr >> 3);
+            this.module.HEAPU32.set(codepoints, codepointsPtr >> 2);
+
+            const pixelsPtr = this.module._generate_atlas_pyramid(
+                this.fontId, codepointsPtr, count, sizesPtr, levels, pixelRange,
+                MODE_INDEX[mode], format === 'uint8' ? 1 : 0, maxSize, charsPtr, sizePtr
+            );
+            if (pixelsPtr === 0) return null;
 
+            const width = this.module.HEAPU32[sizePtr >> 2];
+            const height = this.module.HEAPU32[(sizePtr >> 2) + 1];
+            const rows = this.outputRows(width, MODE_CHANNELS[mode], format);
             return {
-                metrics: { width, height, advance, planeBounds: { l, b, r, t }, atlasBounds: { l: 0, b: 0 } },
-                pixels
+                width, height, channels: rows.channels, rowStride: rows.rowStride,
+                pixels: this.copyPixels(pixelsPtr, rows.rowStride * height, format),
+                levels: fontSizes.map((fontSize, level) => ({
+                    fontSize, ...this.readAtlasChars(charsPtr + level * count * 32, codepoints)
+                }))
             };
         } finally {
-            this.module._free(metricsPtr);
+            this.module._free(sizesPtr);
+        }
+    }
+
+    // Char table of generate_atlas* (8 floats per codepoint): placed glyphs, then the codepoints that were not
+    private readAtlasChars(charsPtr: number, codepoints: number[]): { chars: MSDFAtlasChar[], missing: number[] } {
+        const heap = this.module.HEAPF32;
+        const chars: MSDFAtlasChar[] = [];
+        const missing: number[] = [];
+        for (let i = 0; i < codepoints.length; i++) {
+            const c = (charsPtr >> 2) + i * 8;
+            if (heap[c] === 0.0) {
+                missing.push(codepoints[i]);
+                continue;
+            }
+            chars.push({
+                id: codepoints[i],
+                x: heap[c + 1], y: heap[c + 2],
+                width: heap[c + 3], height: heap[c + 4],
+                xoffset: heap[c + 5], yoffset: heap[c + 6],
+                xadvance: heap[c + 7]
+            });
         }
+        return { chars, missing };
     }
 
     /**
-     * Generate MTSDF glyph with current variation axes (4 channels).
+     * Persistent cache key of an atlas: a hash of the current font's bytes, then a hash of the
+     * arguments, the current variation axes, raster settings (precision, error correction,
+     * sparse mode, contour culling) and output layout, as hex. Same arguments as generateAtlas().
      */
-    generateMTSDFVar(charCode: number, fontSize: number = 32, pixelRange: number = 4.0): MSDFGlyph | null {
+    atlasCacheKey(codepoints: number[], fontSize: number = 32, pixelRange: number = 4.0,
+                  maxSize: number = 2048, mode: MSDFMode = 'mtsdf', format: MSDFPixelFormat = 'uint8'): string {
         if (!this.fontLoaded) throw new Error("Font not loaded");
+        // codepoints (4 bytes each) + key (16 bytes)
+        const codepointsPtr = this.module._malloc(codepoints.length * 4 + 16);
+        const keyPtr = codepointsPtr + codepoints.length * 4;
+        try {
+            this.module.HEAPU32.set(codepoints, codepointsPtr >> 2);
+            this.module._atlas_cache_key(this.fontId, codepointsPtr, codepoints.length, fontSize, pixelRange,
+                                         MODE_INDEX[mode], format === 'uint8' ? 1 : 0, maxSize, keyPtr);
+            return atlasKeyFromWords(this.module.HEAPU32.subarray(keyPtr >> 2, (keyPtr >> 2) + 4));
+        } finally {
+            this.module._free(codepointsPtr);
+        }
+    }
 
-        const metricsPtr = this.module._malloc(40);
+    /**
+     * generateAtlas(), serialized as an atlas file: a 64-byte header, the char table and the
+     * page (16-byte aligned) in one buffer, to store as is and read back with parseAtlasFile().
+     * Defaults to 'uint8' pages, a quarter of the size of 'float32' ones.
+     * @returns The file, or null if no glyph could be generated
+     */
+    generateAtlasFile(codepoints: number[], fontSize: number = 32, pixelRange: number = 4.0,
+                      maxSize: number = 2048, mode: MSDFMode = 'mtsdf',
+                      format: MSDFPixelFormat = 'uint8'): Uint8Array | null {
+        if (!this.fontLoaded) throw new Error("Font not loaded");
+        if (codepoints.length === 0) return null;
+        // codepoints (4 bytes each) + file length (4 bytes)
+        const codepointsPtr = this.module._malloc(codepoints.length * 4 + 4);
+        const lengthPtr = codepointsPtr + codepoints.length * 4;
+        try {
+            this.module.HEAPU32.set(codepoints, codepointsPtr >> 2);
+            const filePtr = this.module._generate_atlas_file(this.fontId, codepointsPtr, codepoints.length, fontSize,
+                                                             pixelRange, MODE_INDEX[mode], format === 'uint8' ? 1 : 0,
+                                                             maxSize, lengthPtr);
+            if (filePtr === 0) return null;
+            return this.module.HEAPU8.slice(filePtr, filePtr + this.module.HEAP32[lengthPtr >> 2]);
+        } finally {
+            this.module._free(codepointsPtr);
+        }
+    }
 
+    /**
+     * generateAtlasFile() through a persistent store: a warm start reads the file back
+     * instead of rasterizing. Keyed by atlasCacheKey(), so another font file, charset, size
+     * or setting misses. A failing store only costs the cache: the atlas is generated anyway.
+     * @param store IndexedDBAtlasStore (browsers), FileAtlasStore (Node) or any MSDFAtlasStore
+     * @returns The atlas (pixels view the stored file), or null if no glyph could be generated
+     */
+    async generateAtlasCached(store: MSDFAtlasStore, codepoints: number[], fontSize: number = 32,
+                              pixelRange: number = 4.0, maxSize: number = 2048, mode: MSDFMode = 'mtsdf',
+                              format: MSDFPixelFormat = 'uint8'): Promise<MSDFAtlasFile | null> {
+        const font = this.fontId;
+        const key = this.atlasCacheKey(codepoints, fontSize, pixelRange, maxSize, mode, format);
+        const stored = await store.get(key).catch(() => null);
+        const cached = stored ? parseAtlasFile(stored) : null;
+        if (cached && cached.key === key) return cached;
+
+        if (this.fontId !== font) throw new Error("Font changed while reading the atlas store");
+        const file = this.generateAtlasFile(codepoints, fontSize, pixelRange, maxSize, mode, format);
+        if (!file) return null;
+        await store.set(key, file).catch(() => undefined);
+        return parseAtlasFile(file);
+    }
+
+    /**
+     * Set the glyph cache budget (default 16 MB of pixel data).
+     * Single glyph calls and generateBatch() keep their results in an LRU cache inside WASM,
+     * keyed by codepoint, fontSize, pixelRange, mode, format and the current variation axes,
+     * so repeated requests skip generation. generateAtlas() and generateInto() bypass it.
+     * @param bytes Budget in bytes; 0 disables the cache and empties it
+     */
+    setCacheBudget(bytes: number): void {
+        this.module._set_glyph_cache_budget(Math.max(0, Math.floor(bytes)));
+    }
+
+    /**
+     * Drop every cached glyph. Hit/miss counters are kept.
+     */
+    clearCache(): void {
+        this.module._clear_glyph_cache();
+    }
+
+    /**
+     * Reset the hit/miss/eviction counters.
+     */
+    resetCacheStats(): void {
+        this.module._reset_glyph_cache_stats();
+    }
+
+    getCacheStats(): MSDFCacheStats {
+        const ptr = this.module._malloc(24);
         try {
-            const pixelsPtr = this.module._generate_mtsdf_glyph_var(
-                this.fontLen, charCode, fontSize, pixelRange, metricsPtr
-            );
+            const heap = this.module.HEAPU32;
+            const o = ptr >> 2;
+            this.module._get_glyph_cache_stats(ptr);
+            return {
+                hits: heap[o], misses: heap[o + 1], evictions: heap[o + 2],
+                entries: heap[o + 3], bytes: heap[o + 4], budget: heap[o + 5]
+            };
+        } finally {
+            this.module._free(ptr);
+        }
+    }
 
-            const metricsOffset = metricsPtr >> 2;
-            const success = this.module.HEAPF32[metricsOffset + 0];
-            if (success === 0.0) return null;
+    /**
+     * Read the per-glyph instrumentation: stage totals plus the most recent glyph records
+     * from the ring buffer in WASM (1024 entries). Only builds made with
+     * `make -f Makefile.wasm STATS=1` record anything; otherwise enabled is false.
+     * @param maxRecords Maximum number of recent records to return (default 256)
+     */
+    getStats(maxRecords: number = 256): MSDFStats {
+        const totalsPtr = this.module._malloc(40 + maxRecords * 40);
+        const recordsPtr = totalsPtr + 40;
+        try {
+            const count = this.module._get_stats(totalsPtr, recordsPtr, maxRecords);
+            const u32 = this.module.HEAPU32;
+            const f32 = this.module.HEAPF32;
+            const t = totalsPtr >> 2;
 
-            const width = this.module.HEAPF32[metricsOffset + 1];
-            const height = this.module.HEAPF32[metricsOffset + 2];
-            const advance = this.module.HEAPF32[metricsOffset + 3];
-            const l = this.module.HEAPF32[metricsOffset + 4];
-            const b = this.module.HEAPF32[metricsOffset + 5];
-            const r = this.module.HEAPF32[metricsOffset + 6];
-            const t = this.module.HEAPF32[metricsOffset + 7];
+            const records: MSDFGlyphStats[] = [];
+            for (let i = 0; i < count; i++) {
+                const r = (recordsPtr >> 2) + i * 10;
+                const flags = u32[r + 1];
+                records.push({
+                    codepoint: u32[r], width: u32[r + 2], height: u32[r + 3], channels: u32[r + 4],
+                    allocBytes: u32[r + 5],
+                    loadUs: f32[r + 6], coloringUs: f32[r + 7], rasterUs: f32[r + 8], packUs: f32[r + 9],
+                    shapeCached: (flags & 1) !== 0, glyphCached: (flags & 2) !== 0, uint8: (flags & 4) !== 0
+                });
+            }
 
-            if (width <= 0 || height <= 0 || width > 4096 || height > 4096) {
-                console.warn(`Invalid glyph dimensions: ${width}x${height} for charCode ${charCode}`);
-                return null;
+            return {
+                enabled: u32[t] !== 0,
+                glyphs: u32[t + 1], shapeCacheHits: u32[t + 2], glyphCacheHits: u32[t + 3],
+                allocBytes: Math.round(f32[t + 5] * 1024),
+                loadMs: f32[t + 6], coloringMs: f32[t + 7], rasterMs: f32[t + 8], packMs: f32[t + 9],
+                records
+            };
+        } finally {
+            this.module._free(totalsPtr);
+        }
+    }
+
+    /**
+     * Clear the instrumentation totals and ring buffer.
+     */
+    resetStats(): void {
+        this.module._reset_stats();
+    }
+
+    /**
+     * Allocate a pixel buffer in WASM memory for generateInto().
+     * @param width Buffer width in pixels
+     * @param height Buffer height in pixels
+     * @param mode 'msdf' (3 channels), 'mtsdf' (4 channels, default) or 'sdf' (1 channel)
+     * @param format 'float32' (default) or 'uint8'
+     */
+    createStagingBuffer(width: number, height: number, mode: MSDFMode = 'mtsdf',
+                        format: MSDFPixelFormat = 'float32'): MSDFStagingBuffer {
+        if (width <= 0 || height <= 0) throw new Error(`Invalid staging buffer size: ${width}x${height}`);
+        const module = this.module;
+        const channels = MODE_CHANNELS[mode];
+        const samples = width * height * channels;
+        const bytes = samples * (format === 'uint8' ? 1 : 4);
+
+        let ptr = module._malloc(bytes);
+        if (ptr === 0) throw new Error("Failed to allocate staging buffer");
+        module.HEAPU8.fill(0, ptr, ptr + bytes);
+
+        return {
+            get ptr() { return ptr; },
+            width, height, mode, format, channels,
+            view() {
+                if (ptr === 0) throw new Error("Staging buffer freed");
+                if (format === 'uint8') return module.HEAPU8.subarray(ptr, ptr + samples);
+                return module.HEAPF32.subarray(ptr >> 2, (ptr >> 2) + samples);
+            },
+            free() {
+                if (ptr !== 0) module._free(ptr);
+                ptr = 0;
             }
+        };
+    }
+
+    /**
+     * Generate a glyph straight into a staging buffer, with its bottom-left pixel at (x, y).
+     * Uses the buffer's mode and format and the current variation axes.
+     * @param charCode Unicode codepoint
+     * @param staging Buffer from createStagingBuffer()
+     * @param x Left edge in the buffer (pixels)
+     * @param y Bottom edge in the buffer (pixels, buffer row order)
+     * @param fontSize Target size in pixels
+     * @param pixelRange MSDF range (default 4.0)
+     * @returns Metrics plus whether the glyph fit, or null if it failed to load
+     */
+    generateInto(charCode: number, staging: MSDFStagingBuffer, x: number, y: number,
+                 fontSize: number = 32, pixelRange: number = 4.0): MSDFIntoResult | null {
+        if (!this.fontLoaded) throw new Error("Font not loaded");
+        if (staging.ptr === 0) throw new Error("Staging buffer freed");
+        if (x < 0 || y < 0 || x >= staging.width || y >= staging.height) {
+            throw new Error(`Position (${x}, ${y}) outside the staging buffer`);
+        }
 
-            const pixelCount = width * height * 4;
-            const pixels = new Float32Array(pixelCount);
-            const pixelsOffset = pixelsPtr >> 2;
-            pixels.set(this.module.HEAPF32.subarray(pixelsOffset, pixelsOffset + pixelCount));
+        const sampleBytes = staging.format === 'uint8' ? 1 : 4;
+        const rowStride = staging.width * staging.channels;
+        const dest = staging.ptr + (y * rowStride + x * staging.channels) * sampleBytes;
+        const metricsPtr = this.module._malloc(40);
+
+        try {
+            const written = this.module._generate_glyph_into(
+                this.fontId, charCode, fontSize, pixelRange,
+                MODE_INDEX[staging.mode], staging.format === 'uint8' ? 1 : 0,
+                dest, staging.width - x, staging.height - y, rowStride, metricsPtr
+            );
+
+            const m = metricsPtr >> 2;
+            const heap = this.module.HEAPF32;
+            if (heap[m] === 0.0) return null;
 
             return {
-                metrics: { width, height, advance, planeBounds: { l, b, r, t }, atlasBounds: { l: 0, b: 0 } },
-                pixels
+                metrics: {
+                    width: heap[m + 1], height: heap[m + 2], advance: heap[m + 3],
+                    planeBounds: { l: heap[m + 4], b: heap[m + 5], r: heap[m + 6], t: heap[m + 7] },
+                    atlasBounds: { l: x, b: y }
+                },
+                written: written !== 0
             };
         } finally {
             this.module._free(metricsPtr);
@@ -323,5 +1571,8 @@ export class MSDFGenerator {
     dispose() {
         this.module._free_buffers();
         this.fontLoaded = false;
+        this.fontId = 0;
+        this.fonts.clear();
+        this.replaceableFont = 0;
     }
 }
\ No newline at end of file
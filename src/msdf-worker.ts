@@ -0,0 +1,210 @@
+/**
+ * MSDFWorker - runs an MSDFGenerator in a dedicated worker (libMSDF-worker.js) so generation
+ * never blocks the calling thread. Every call is a Promise; pixel buffers come back as
+ * transferables, without a copy.
+ */
+
+import type { MSDFGenerator, MSDFInitOptions, MSDFGlyph, MSDFAtlas, MSDFMode, MSDFPixelFormat,
+              MSDFFontHandle, MSDFAsyncOptions, MSDFStreamSlice } from './msdf-generator.js';
+
+// MSDFGenerator methods the worker serves through call()
+export const WORKER_METHODS = [
+    'loadFont', 'addFont', 'useFont', 'closeFont', 'hasGlyph', 'getCoverage',
+    'getFontMetrics', 'getKerning', 'getKerningTable',
+    'setPrecision', 'setErrorCorrection', 'setSparseRaster', 'setEdgeGrid', 'setOutputLayout',
+    'setVariationAxes', 'setVariationStep', 'clearVariationAxes',
+    'setOutlineCacheCapacity', 'setCacheBudget', 'clearCache', 'resetCacheStats', 'getCacheStats',
+    'getStats', 'resetStats',
+    'generate', 'generateMTSDF', 'generateSDF', 'generateVar', 'generateMTSDFVar',
+    'generateBatch', 'generateByGlyphIndex', 'generateBatchByGlyphIndex', 'measureGlyphs', 'generateAtlas', 'generateAtlasPyramid',
+    'atlasCacheKey', 'generateAtlasFile'
+] as const;
+
+export type MSDFWorkerMethod = typeof WORKER_METHODS[number];
+
+type MethodArgs<K extends MSDFWorkerMethod> = MSDFGenerator[K] extends (...args: infer A) => any ? A : never;
+type MethodResult<K extends MSDFWorkerMethod> = MSDFGenerator[K] extends (...args: any[]) => infer R ? R : never;
+
+// Main thread -> worker
+export type WorkerRequest =
+    | { id: number, type: 'init', modulePath: string, options: MSDFInitOptions }
+    | { id: number, type: 'call', method: MSDFWorkerMethod, args: unknown[] }
+    | { id: number, type: 'stream', codepoints: number[], fontSize: number, pixelRange: number,
+        options: Omit<MSDFAsyncOptions, 'signal'> }
+    | { id: number, type: 'cancel', target: number };
+
+// Worker -> main thread; a stream sends any number of slices before its result
+export type WorkerResponse =
+    | { id: number, type: 'result', value: unknown }
+    | { id: number, type: 'slice', slice: MSDFStreamSlice }
+    | { id: number, type: 'error', message: string };
+
+// Buffers of every typed array in a result (glyph pixels, atlas pages, coverage tables), each once
+export function resultTransferables(value: unknown): ArrayBuffer[] {
+    const buffers = new Set<ArrayBuffer>();
+    const visit = (v: any) => {
+        if (!v || typeof v !== 'object') return;
+        if (ArrayBuffer.isView(v)) {
+            if (v.buffer instanceof ArrayBuffer) buffers.add(v.buffer);
+        } else if (Array.isArray(v)) {
+            v.forEach(visit);
+        } else {
+            visit(v.pixels);
+            visit(v.glyphs);
+        }
+    };
+    visit(value);
+    return [...buffers];
+}
+
+interface Pending {
+    resolve: (value: any) => void;
+    reject: (error: Error) => void;
+    onSlice?: (slice: MSDFStreamSlice) => void;
+}
+
+export class MSDFWorker {
+    private worker: Worker;
+    private nextId: number = 1;
+    private pending: Map<number, Pending> = new Map();
+
+    private constructor(worker: Worker) {
+        this.worker = worker;
+        worker.onmessage = (event: MessageEvent<WorkerResponse>) => this.receive(event.data);
+        worker.onerror = (event: ErrorEvent) => {
+            const error = new Error(event.message || "libMSDF worker failed");
+            for (const pending of this.pending.values()) pending.reject(error);
+            this.pending.clear();
+        };
+    }
+
+    /**
+     * Start a generator in a worker running libMSDF-worker.js, e.g.
+     * new Worker(new URL('./libMSDF-worker.js', import.meta.url), { type: 'module' }).
+     * @param worker The worker; owned by the MSDFWorker from here on (see terminate())
+     * @param modulePath Path to libMSDF.wasm, resolved by the worker (use an absolute URL)
+     * @param options SIMD module selection, as for MSDFGenerator.init()
+     */
+    static async create(worker: Worker, modulePath: string, options: MSDFInitOptions = {}): Promise<MSDFWorker> {
+        const client = new MSDFWorker(worker);
+        await client.send({ type: 'init', modulePath, options }).done;
+        return client;
+    }
+
+    /**
+     * Run an MSDFGenerator method in the worker, e.g. call('generateMTSDF', 65, 48).
+     * Arguments are structured-cloned; pass transfer to move buffers (e.g., font bytes) instead.
+     */
+    call<K extends MSDFWorkerMethod>(method: K, ...args: MethodArgs<K>): Promise<MethodResult<K>> {
+        return this.send({ type: 'call', method, args }).done;
+    }
+
+    /**
+     * Load a font, moving its bytes to the worker (fontBytes is detached afterwards).
+     */
+    loadFont(fontBytes: Uint8Array): Promise<void> {
+        return this.send({ type: 'call', method: 'loadFont', args: [fontBytes] }, [fontBytes.buffer as ArrayBuffer]).done;
+    }
+
+    /**
+     * Add a font by handle (see MSDFGenerator.addFont()), moving its bytes to the worker.
+     */
+    addFont(fontBytes: Uint8Array): Promise<MSDFFontHandle> {
+        return this.send({ type: 'call', method: 'addFont', args: [fontBytes] }, [fontBytes.buffer as ArrayBuffer]).done;
+    }
+
+    generateBatch(codepoints: number[], fontSize: number = 32, pixelRange: number = 4.0,
+                  mode: MSDFMode = 'mtsdf', format: MSDFPixelFormat = 'float32'): Promise<(MSDFGlyph | null)[]> {
+        return this.call('generateBatch', codepoints, fontSize, pixelRange, mode, format);
+    }
+
+    generateAtlas(codepoints: number[], fontSize: number = 32, pixelRange: number = 4.0,
+                  maxSize: number = 2048, mode: MSDFMode = 'mtsdf',
+                  format: MSDFPixelFormat = 'float32'): Promise<MSDFAtlas | null> {
+        return this.call('generateAtlas', codepoints, fontSize, pixelRange, maxSize, mode, format);
+    }
+
+    /**
+     * MSDFGenerator.streamCharset() in the worker: one message per slice. Other calls
+     * (e.g., a visible glyph needed now) are served between slices.
+     */
+    async *streamCharset(codepoints: number[], fontSize: number = 32, pixelRange: number = 4.0,
+                         options: MSDFAsyncOptions = {}): AsyncGenerator<MSDFStreamSlice> {
+        const { signal, ...rest } = options;
+        const queue: MSDFStreamSlice[] = [];
+        let wake: (() => void) | null = null;
+        let finished = false;
+        let failure: Error | null = null;
+
+        const stream = this.send({ type: 'stream', codepoints, fontSize, pixelRange, options: rest }, [], slice => {
+            queue.push(slice);
+            if (wake) wake();
+        });
+        stream.done.then(() => { finished = true; }, (error: Error) => { failure = error; finished = true; })
+            .then(() => { if (wake) wake(); });
+        const cancel = () => this.worker.postMessage({ id: this.nextId++, type: 'cancel', target: stream.id });
+        signal?.addEventListener('abort', cancel);
+
+        try {
+            while (true) {
+                if (queue.length > 0) {
+                    yield queue.shift()!;
+                } else if (finished) {
+                    break;
+                } else {
+                    await new Promise<void>(resolve => { wake = resolve; });
+                    wake = null;
+                }
+            }
+            if (failure) throw failure;
+        } finally {
+            signal?.removeEventListener('abort', cancel);
+            if (!finished) cancel(); // Consumer stopped early
+        }
+    }
+
+    /**
+     * MSDFGenerator.generateAsync() in the worker.
+     */
+    async generateAsync(codepoints: number[], fontSize: number = 32, pixelRange: number = 4.0,
+                        options: MSDFAsyncOptions = {}): Promise<(MSDFGlyph | null)[]> {
+        const byCode = new Map<number, MSDFGlyph | null>();
+        for await (const slice of this.streamCharset(codepoints, fontSize, pixelRange, options)) {
+            slice.codepoints.forEach((code, i) => byCode.set(code, slice.glyphs[i]));
+        }
+        if (options.signal?.aborted) throw options.signal.reason ?? new Error("Aborted");
+        return codepoints.map(code => byCode.get(code) ?? null);
+    }
+
+    /**
+     * Stop the worker and its module. Pending calls are rejected.
+     */
+    terminate(): void {
+        this.worker.terminate();
+        const error = new Error("libMSDF worker terminated");
+        for (const pending of this.pending.values()) pending.reject(error);
+        this.pending.clear();
+    }
+
+    private send(request: any, transfer: Transferable[] = [],
+                 onSlice?: (slice: MSDFStreamSlice) => void): { id: number, done: Promise<any> } {
+        const id = this.nextId++;
+        const done = new Promise<any>((resolve, reject) => {
+            this.pending.set(id, { resolve, reject, onSlice });
+        });
+        this.worker.postMessage({ ...request, id }, transfer);
+        return { id, done };
+    }
+
+    private receive(response: WorkerResponse): void {
+        const pending = this.pending.get(response.id);
+        if (!pending) return;
+        if (response.type === 'slice') {
+            pending.onSlice?.(response.slice);
+            return;
+        }
+        this.pending.delete(response.id);
+        if (response.type === 'error') pending.reject(new Error(response.message));
+        else pending.resolve(response.value);
+    }
+}
@@ -0,0 +1,401 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <climits>
+#include "core.h"
+#include "thread_pool.h"
+
+// Atlas mode: pack a charset into one page and rasterize every glyph in place.
+
+namespace msdf_core {
+
+    // Gap between packed glyphs, in pixels
+    static const int ATLAS_SPACING = 1;
+
+    /**
+     * Skyline bottom-left rectangle packer.
+     * Keeps the top edge of the packed area as a list of horizontal segments and places
+     * each rectangle where its top ends up lowest.
+     */
+    class SkylinePacker {
+    public:
+        SkylinePacker(int width, int height) : width(width), height(height) {
+            skyline.push_back({0, 0, width});
+        }
+
+        /**
+         * Place a w x h rectangle.
+         * Returns false (and leaves the packer unchanged) if it does not fit.
+         */
+        bool pack(int w, int h, int& outX, int& outY) {
+            int bestIndex = -1;
+            int bestY = 0;
+            int bestTop = INT_MAX;
+            int bestWidth = INT_MAX;
+            for (int i = 0; i < (int)skyline.size(); ++i) {
+                int y;
+                if (!fits(i, w, h, y)) continue;
+                int top = y + h;
+                if (top < bestTop || (top == bestTop && skyline[i].width < bestWidth)) {
+                    bestIndex = i;
+                    bestY = y;
+                    bestTop = top;
+                    bestWidth = skyline[i].width;
+                }
+            }
+            if (bestIndex < 0) return false;
+
+            outX = skyline[bestIndex].x;
+            outY = bestY;
+            addSegment(bestIndex, outX, bestTop, w);
+            return true;
+        }
+
+    private:
+        struct Segment {
+            int x, y, width;
+        };
+
+        int width, height;
+        std::vector<Segment> skyline;
+
+        // Lowest y at which a w x h rectangle starting at segment index fits
+        bool fits(int index, int w, int h, int& outY) const {
+            int x = skyline[index].x;
+            if (x + w > width) return false;
+
+            int y = 0;
+            int remaining = w;
+            for (int i = index; remaining > 0 && i < (int)skyline.size(); ++i) {
+                y = std::max(y, skyline[i].y);
+                if (y + h > height) return false;
+                remaining -= skyline[i].width;
+            }
+            outY = y;
+            return true;
+        }
+
+        void addSegment(int index, int x, int y, int w) {
+            skyline.insert(skyline.begin() + index, {x, y, w});
+
+            // Trim or drop the segments now covered by the new one
+            int end = x + w;
+            for (int i = index + 1; i < (int)skyline.size();) {
+                Segment& segment = skyline[i];
+                if (segment.x >= end) break;
+                int overlap = end - segment.x;
+                if (overlap < segment.width) {
+                    segment.x += overlap;
+                    segment.width -= overlap;
+                    break;
+                }
+                skyline.erase(skyline.begin() + i);
+            }
+
+            // Merge neighbours at the same height
+            for (int i = 0; i + 1 < (int)skyline.size();) {
+                if (skyline[i].y == skyline[i + 1].y) {
+                    skyline[i].width += skyline[i + 1].width;
+                    skyline.erase(skyline.begin() + i + 1);
+                } else {
+                    ++i;
+                }
+            }
+        }
+    };
+
+    /**
+     * One entry of the atlas char table (BMFont-style).
+     * x, y address the page in its row order (row 0 = first row of the pixel buffer,
+     * which is the bottom row like single glyph bitmaps, or the top row in a top-down
+     * OutputLayout; either way the slot's first row holds the glyph's first row).
+     */
+    struct AtlasGlyph {
+        uint32_t codepoint;
+        bool placed;            // False if the glyph failed to load or did not fit
+        int x, y;               // Bitmap position in the page (pixels)
+        int width, height;      // Bitmap size; 0 x 0 for empty glyphs (e.g., space)
+        float xoffset;          // Bitmap left edge relative to the pen position (pixels)
+        float yoffset;          // Bitmap top edge relative to the baseline, y up (pixels)
+        float xadvance;         // Horizontal advance (pixels)
+    };
+
+    struct AtlasResult {
+        bool success;           // False if nothing could be generated
+        int width, height;      // Page size in pixels
+        int channels;           // Per stored pixel: 1 for SDF, 3 for MSDF, 4 for MTSDF (or padded MSDF)
+        int rowStride;          // Samples from one page row to the next
+        std::vector<AtlasGlyph> glyphs; // One entry per requested codepoint, in input order
+    };
+
+    /**
+     * Char table entry of a loaded (or failed) glyph, before packing.
+     * Returns true if the glyph has a bitmap and needs a slot; empty glyphs are placed as is.
+     */
+    inline bool describeAtlasGlyph(AtlasGlyph& glyph, uint32_t codepoint, const GlyphGeometry& geo, bool loaded) {
+        glyph.codepoint = codepoint;
+        glyph.placed = false;
+        glyph.x = glyph.y = 0;
+        glyph.width = glyph.height = 0;
+        glyph.xoffset = glyph.yoffset = glyph.xadvance = 0;
+        if (!loaded) return false;
+
+        glyph.xadvance = (float)(geo.advance * geo.scale);
+        if (geo.empty) {
+            // Nothing to draw, but the advance is still needed for layout
+            glyph.placed = true;
+            return false;
+        }
+        glyph.width = geo.width;
+        glyph.height = geo.height;
+        glyph.xoffset = (float)geo.frameL;
+        glyph.yoffset = (float)(geo.frameB + geo.height);
+        return true;
+    }
+
+    /**
+     * Rasterize a packed glyph into its slot of a page (rows rowStride samples apart, stored
+     * per layout). In a top-down page the slot's row y holds the glyph's top row.
+     */
+    inline void renderAtlasSlot(uint8_t* page, int rowStride, int format, int channels, const AtlasGlyph& glyph,
+                                const GlyphGeometry& geo, double pixelRange, const RasterOptions& options,
+                                const OutputLayout& layout = OutputLayout()) {
+        int sampleBytes = format == FORMAT_UINT8 ? 1 : (int)sizeof(float);
+        int stored = layout.storedChannels(channels);
+        PixelTarget slot = layout.target(
+            page + ((size_t)glyph.y * rowStride + (size_t)glyph.x * stored) * sampleBytes,
+            glyph.width, glyph.height, channels, format);
+        slot.rowStride = rowStride;
+        renderInto(slot, channels, geo, pixelRange, options);
+    }
+
+    // Pack rectangles in the given order; returns the number placed
+    inline int packGlyphs(const std::vector<GlyphGeometry>& geometry, const std::vector<int>& order,
+                          int width, int height, std::vector<AtlasGlyph>& glyphs) {
+        SkylinePacker packer(width, height);
+        int placed = 0;
+        for (int index : order) {
+            AtlasGlyph& glyph = glyphs[index];
+            const GlyphGeometry& geo = geometry[index];
+            glyph.placed = packer.pack(geo.width + ATLAS_SPACING, geo.height + ATLAS_SPACING, glyph.x, glyph.y);
+            if (glyph.placed) placed++;
+        }
+        return placed;
+    }
+
+    /**
+     * Pack prepared glyphs into one page and render each directly into its slot (no per-glyph
+     * bitmap). Entry i is codepoints[i] with geometry[i]; entries that did not load are reported
+     * as not placed.
+     *
+     * Glyphs are packed into the smallest page (doubling from a power of two, up to
+     * maxSize x maxSize) that holds all of them, and the page height is trimmed to the
+     * used area. Glyphs that still do not fit at maxSize are reported as not placed.
+     * Rasterization is spread over the thread pool in threaded builds.
+     *
+     * @param format FORMAT_FLOAT32 renders into pixels, FORMAT_UINT8 into bytes
+     * @param pixels Output page for float output (rowStride * height floats), resized as needed
+     * @param bytes Output page for byte output (rowStride * height bytes), resized as needed
+     * @param layout Row order, row alignment and channel padding of the page
+     */
+    inline AtlasResult packAtlas(FontSession& session, int mode, int format, const uint32_t* codepoints,
+                                 const std::vector<GlyphGeometry>& geometry, const std::vector<char>& loaded,
+                                 double pixelRange, int maxSize, std::vector<float>& pixels, std::vector<uint8_t>& bytes,
+                                 const RasterOptions& options, const OutputLayout& layout) {
+        int count = (int)geometry.size();
+        AtlasResult result;
+        result.success = false;
+        result.width = 0;
+        result.height = 0;
+        result.channels = layout.storedChannels(modeChannels(mode));
+        result.rowStride = 0;
+        result.glyphs.resize(count);
+
+        std::vector<int> order;
+        long long area = 0;
+        int widest = 0;
+        for (int i = 0; i < count; ++i) {
+            const GlyphGeometry& geo = geometry[i];
+            if (!describeAtlasGlyph(result.glyphs[i], codepoints[i], geo, loaded[i] != 0)) continue;
+
+            order.push_back(i);
+            area += (long long)(geo.width + ATLAS_SPACING) * (geo.height + ATLAS_SPACING);
+            widest = std::max(widest, geo.width + ATLAS_SPACING);
+        }
+
+        // 1. Pack tallest first, growing the page until everything fits
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+            return geometry[a].height > geometry[b].height;
+        });
+
+        int width = 1;
+        while (width < maxSize && ((long long)width * width < area || width < widest)) width *= 2;
+        width = std::min(width, maxSize);
+        int height = width;
+        while (packGlyphs(geometry, order, width, height, result.glyphs) < (int)order.size()) {
+            if (width >= maxSize && height >= maxSize) break; // Keep the partial packing
+            if (width <= height && width < maxSize) width = std::min(width * 2, maxSize);
+            else height = std::min(height * 2, maxSize);
+        }
+
+        int usedHeight = 0;
+        for (int index : order) {
+            const AtlasGlyph& glyph = result.glyphs[index];
+            if (glyph.placed) usedHeight = std::max(usedHeight, glyph.y + glyph.height);
+        }
+
+        // 2. Render every placed glyph straight into its slot (slots never overlap, so in parallel)
+        int channels = modeChannels(mode);
+        int rowStride = layout.rowStride(width, channels, format);
+        size_t pageSamples = (size_t)rowStride * usedHeight;
+
+        uint8_t* page;
+        if (format == FORMAT_UINT8) {
+            if (bytes.size() < pageSamples) {
+                bytes.resize(pageSamples);
+            }
+            std::fill(bytes.begin(), bytes.begin() + pageSamples, (uint8_t)0);
+            page = bytes.data();
+        } else {
+            if (pixels.size() < pageSamples) {
+                pixels.resize(pageSamples);
+            }
+            std::fill(pixels.begin(), pixels.begin() + pageSamples, 0.0f);
+            page = (uint8_t*)pixels.data();
+        }
+
+        parallelGlyphs(session, (int)order.size(), [&](FontSession&, int k) {
+            int index = order[k];
+            const AtlasGlyph& glyph = result.glyphs[index];
+            if (!glyph.placed) return;
+            renderAtlasSlot(page, rowStride, format, channels, glyph, geometry[index], pixelRange, options, layout);
+        });
+
+        bool anyPlaced = false;
+        for (const AtlasGlyph& glyph : result.glyphs) anyPlaced = anyPlaced || glyph.placed;
+
+        result.success = anyPlaced;
+        result.width = width;
+        result.height = usedHeight;
+        result.rowStride = rowStride;
+        return result;
+    }
+
+    /**
+     * Generate an atlas page for a charset with the given axes (numAxes = 0 for defaults).
+     * Every glyph is loaded and measured first (on the thread pool in threaded builds), so the
+     * page can be sized before rendering; packing and rendering are packAtlas.
+     */
+    inline AtlasResult generateAtlas(FontSession& session, int mode, int format, const uint32_t* codepoints, int count,
+                                     double fontSize, double pixelRange, int maxSize,
+                                     const VariationAxis* axes, int numAxes,
+                                     std::vector<float>& pixels, std::vector<uint8_t>& bytes,
+                                     const RasterOptions& options = RasterOptions(),
+                                     const OutputLayout& layout = OutputLayout()) {
+        std::vector<GlyphGeometry> geometry(count);
+        std::vector<char> loaded(count, 0);
+        parallelGlyphs(session, count, [&](FontSession& face, int i) {
+            setSessionAxes(face, axes, numAxes);
+            loaded[i] = prepareGlyph(face, codepoints[i], fontSize, pixelRange, geometry[i]);
+        });
+        return packAtlas(session, mode, format, codepoints, geometry, loaded, pixelRange, maxSize,
+                         pixels, bytes, options, layout);
+    }
+
+    /**
+     * One atlas page holding a charset at several sizes (e.g., a mip chain 128, 64, 32 with the
+     * same pixel range, so the distance range stays constant in texels).
+     * Each glyph is loaded and edge-colored once; every level reuses that outline with its own
+     * frame, so only rasterization scales with the number of levels.
+     * Glyph entry l * count + i is codepoints[i] at fontSizes[l].
+     */
+    inline AtlasResult generateAtlasPyramid(FontSession& session, int mode, int format, const uint32_t* codepoints,
+                                            int count, const double* fontSizes, int numSizes, double pixelRange,
+                                            int maxSize, const VariationAxis* axes, int numAxes,
+                                            std::vector<float>& pixels, std::vector<uint8_t>& bytes,
+                                            const RasterOptions& options = RasterOptions(),
+                                            const OutputLayout& layout = OutputLayout()) {
+        size_t entries = (size_t)count * (numSizes > 0 ? numSizes : 0);
+        std::vector<GlyphGeometry> geometry(entries);
+        std::vector<char> loaded(entries, 0);
+        std::vector<uint32_t> entryCodepoints(entries);
+        if (entries == 0) {
+            return packAtlas(session, mode, format, entryCodepoints.data(), geometry, loaded, pixelRange, maxSize,
+                             pixels, bytes, options, layout);
+        }
+
+        parallelGlyphs(session, count, [&](FontSession& face, int i) {
+            setSessionAxes(face, axes, numAxes);
+            loaded[i] = prepareGlyph(face, codepoints[i], fontSizes[0], pixelRange, geometry[i]);
+        });
+        for (int level = 0; level < numSizes; ++level) {
+            for (int i = 0; i < count; ++i) {
+                size_t entry = (size_t)level * count + i;
+                entryCodepoints[entry] = codepoints[i];
+                if (level == 0 || !loaded[i]) continue;
+                resizeGlyph(session, geometry[i], fontSizes[level], pixelRange, geometry[entry]);
+                loaded[entry] = 1;
+            }
+        }
+        return packAtlas(session, mode, format, entryCodepoints.data(), geometry, loaded, pixelRange, maxSize,
+                         pixels, bytes, options, layout);
+    }
+
+    /**
+     * An atlas page filled a few glyphs at a time, for progressive texture uploads.
+     * The page is caller-owned and fixed in size, so a slot never moves once reported;
+     * glyphs that no longer fit are reported as not placed. Glyphs are packed in the order
+     * given (the caller's priority order), which packs less tightly than generateAtlas's
+     * tallest-first order.
+     */
+    class StreamingAtlas {
+    public:
+        /**
+         * @param page Page memory: width * height * channels samples of format, rows bottom-to-top
+         */
+        StreamingAtlas(uint8_t* page, int width, int height, int mode, int format)
+            : page(page), width(width), mode(mode), format(format), packer(width, height) {}
+
+        /**
+         * Pack and render glyphs with the given axes (numAxes = 0 for defaults), one char table
+         * entry per codepoint to out. Loading and rasterization use the thread pool in threaded builds.
+         * @return Number of glyphs placed (including empty ones)
+         */
+        int add(FontSession& session, const uint32_t* codepoints, int count, double fontSize, double pixelRange,
+                const VariationAxis* axes, int numAxes, AtlasGlyph* out,
+                const RasterOptions& options = RasterOptions()) {
+            std::vector<GlyphGeometry> geometry(count);
+            std::vector<char> loaded(count, 0);
+            parallelGlyphs(session, count, [&](FontSession& face, int i) {
+                setSessionAxes(face, axes, numAxes);
+                loaded[i] = prepareGlyph(face, codepoints[i], fontSize, pixelRange, geometry[i]);
+            });
+
+            std::vector<int> order;
+            for (int i = 0; i < count; ++i) {
+                AtlasGlyph& glyph = out[i];
+                if (!describeAtlasGlyph(glyph, codepoints[i], geometry[i], loaded[i] != 0)) continue;
+                glyph.placed = packer.pack(glyph.width + ATLAS_SPACING, glyph.height + ATLAS_SPACING, glyph.x, glyph.y);
+                if (glyph.placed) order.push_back(i);
+            }
+
+            int channels = modeChannels(mode);
+            parallelGlyphs(session, (int)order.size(), [&](FontSession&, int k) {
+                int index = order[k];
+                renderAtlasSlot(page, width * channels, format, channels, out[index], geometry[index], pixelRange, options);
+            });
+
+            int placed = 0;
+            for (int i = 0; i < count; ++i) placed += out[i].placed ? 1 : 0;
+            return placed;
+        }
+
+    private:
+        uint8_t* page;
+        int width;
+        int mode;
+        int format;
+        SkylinePacker packer;
+    };
+}
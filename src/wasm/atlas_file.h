@@ -0,0 +1,158 @@
+#pragma once
+
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include "core.h"
+#include "atlas.h"
+
+// Atlas files: a baked atlas page and its char table as one flat blob, for persistent caches.
+
+namespace msdf_core {
+
+    static const uint32_t ATLAS_FILE_MAGIC = 0x4144534d;   // "MSDA" as little-endian bytes
+    static const uint16_t ATLAS_FILE_VERSION = 1;
+    static const uint32_t ATLAS_FILE_ALIGN = 16;           // Alignment of the pixel page
+
+    /**
+     * Fixed 64-byte header, little-endian like every field in the file. Sections follow in
+     * this order: axes (axisCount AtlasFileAxis), glyphs (glyphCount AtlasFileGlyph) and,
+     * at pixelOffset, the page exactly as generate_atlas returns it. Readers can upload the
+     * page straight from the file (or a mapping of it) without touching the glyph table.
+     */
+    struct AtlasFileHeader {
+        uint32_t magic;             // ATLAS_FILE_MAGIC
+        uint16_t version;           // ATLAS_FILE_VERSION
+        uint16_t headerSize;        // sizeof(AtlasFileHeader)
+        uint8_t mode;               // GlyphMode
+        uint8_t format;             // PixelFormat
+        uint8_t channels;           // Per stored pixel (4 for padded MSDF)
+        uint8_t layout;             // OutputLayout::key(): bit 0 top-down, bit 1 padded, bits 2+ log2(row alignment)
+        uint32_t width, height;     // Page size in pixels
+        uint32_t glyphCount;
+        uint32_t axisCount;
+        float fontSize;
+        float pixelRange;
+        uint32_t fontHash[2];       // FontSession::contentHash (low word first)
+        uint32_t settingsHash[2];   // atlasSettingsHash
+        uint32_t glyphOffset;       // Byte offsets from the start of the file
+        uint32_t pixelOffset;
+        uint32_t pixelBytes;
+    };
+    static_assert(sizeof(AtlasFileHeader) == 64, "atlas file header is 64 bytes");
+
+    struct AtlasFileAxis {
+        uint32_t tag;               // 4 ASCII bytes, first character in the low byte
+        float value;
+    };
+
+    // AtlasGlyph on disk (36 bytes); every requested codepoint has one, placed or not
+    struct AtlasFileGlyph {
+        uint32_t codepoint;
+        uint32_t placed;
+        uint32_t x, y, width, height;
+        float xoffset, yoffset, xadvance;
+    };
+
+    /**
+     * Hash of everything besides the font that changes an atlas: charset (in order), size,
+     * range, page limit, mode, format, raster options, output layout and variation axes.
+     * Together with the font hash it is the persistent cache key.
+     */
+    inline uint64_t atlasSettingsHash(const uint32_t* codepoints, int count, double fontSize, double pixelRange,
+                                      int maxSize, int mode, int format, const VariationAxis* axes, int numAxes,
+                                      const RasterOptions& options, const OutputLayout& layout = OutputLayout()) {
+        uint64_t h = hashBytes(codepoints, (size_t)count * sizeof(uint32_t), ATLAS_FILE_VERSION);
+        double sizes[3] = { fontSize, pixelRange, (double)maxSize };
+        h = hashBytes(sizes, sizeof(sizes), h);
+        int32_t settings[4] = { mode, format, options.key(), layout.key() };
+        h = hashBytes(settings, sizeof(settings), h);
+        for (int i = 0; i < numAxes; ++i) {
+            h = hashBytes(axes[i].tag, 4, h);
+            h = hashBytes(&axes[i].value, sizeof(double), h);
+        }
+        return h;
+    }
+
+    /**
+     * Serialize a generated atlas.
+     * @param pixels The page generateAtlas wrote (float samples or bytes, per format)
+     * @param layout The layout the page was generated with
+     * @param out Receives the file; reused storage is fine
+     */
+    inline void writeAtlasFile(const AtlasResult& atlas, const void* pixels, int mode, int format,
+                               double fontSize, double pixelRange, uint64_t fontHash, uint64_t settingsHash,
+                               const VariationAxis* axes, int numAxes, std::vector<uint8_t>& out,
+                               const OutputLayout& layout = OutputLayout()) {
+        size_t sampleBytes = format == FORMAT_UINT8 ? 1 : sizeof(float);
+        size_t pixelBytes = (size_t)atlas.rowStride * atlas.height * sampleBytes;
+        size_t glyphOffset = sizeof(AtlasFileHeader) + (size_t)numAxes * sizeof(AtlasFileAxis);
+        size_t tableEnd = glyphOffset + atlas.glyphs.size() * sizeof(AtlasFileGlyph);
+        size_t pixelOffset = (tableEnd + ATLAS_FILE_ALIGN - 1) / ATLAS_FILE_ALIGN * ATLAS_FILE_ALIGN;
+        out.assign(pixelOffset + pixelBytes, 0);
+
+        AtlasFileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        header.magic = ATLAS_FILE_MAGIC;
+        header.version = ATLAS_FILE_VERSION;
+        header.headerSize = sizeof(AtlasFileHeader);
+        header.mode = (uint8_t)mode;
+        header.format = (uint8_t)format;
+        header.channels = (uint8_t)atlas.channels;
+        header.layout = (uint8_t)layout.key();
+        header.width = (uint32_t)atlas.width;
+        header.height = (uint32_t)atlas.height;
+        header.glyphCount = (uint32_t)atlas.glyphs.size();
+        header.axisCount = (uint32_t)numAxes;
+        header.fontSize = (float)fontSize;
+        header.pixelRange = (float)pixelRange;
+        header.fontHash[0] = (uint32_t)fontHash;
+        header.fontHash[1] = (uint32_t)(fontHash >> 32);
+        header.settingsHash[0] = (uint32_t)settingsHash;
+        header.settingsHash[1] = (uint32_t)(settingsHash >> 32);
+        header.glyphOffset = (uint32_t)glyphOffset;
+        header.pixelOffset = (uint32_t)pixelOffset;
+        header.pixelBytes = (uint32_t)pixelBytes;
+        std::memcpy(out.data(), &header, sizeof(header));
+
+        uint8_t* cursor = out.data() + sizeof(AtlasFileHeader);
+        for (int i = 0; i < numAxes; ++i) {
+            AtlasFileAxis axis;
+            axis.tag = (uint32_t)(uint8_t)axes[i].tag[0] | (uint32_t)(uint8_t)axes[i].tag[1] << 8 |
+                       (uint32_t)(uint8_t)axes[i].tag[2] << 16 | (uint32_t)(uint8_t)axes[i].tag[3] << 24;
+            axis.value = (float)axes[i].value;
+            std::memcpy(cursor, &axis, sizeof(axis));
+            cursor += sizeof(axis);
+        }
+        for (const AtlasGlyph& glyph : atlas.glyphs) {
+            AtlasFileGlyph entry;
+            entry.codepoint = glyph.codepoint;
+            entry.placed = glyph.placed ? 1 : 0;
+            entry.x = (uint32_t)glyph.x;
+            entry.y = (uint32_t)glyph.y;
+            entry.width = (uint32_t)glyph.width;
+            entry.height = (uint32_t)glyph.height;
+            entry.xoffset = glyph.xoffset;
+            entry.yoffset = glyph.yoffset;
+            entry.xadvance = glyph.xadvance;
+            std::memcpy(cursor, &entry, sizeof(entry));
+            cursor += sizeof(entry);
+        }
+        if (pixelBytes) std::memcpy(out.data() + pixelOffset, pixels, pixelBytes);
+    }
+
+    /**
+     * Check that data holds a complete atlas file of this version.
+     * Returns the header (copied out, so data needs no alignment) or false.
+     */
+    inline bool readAtlasFileHeader(const uint8_t* data, size_t length, AtlasFileHeader& header) {
+        if (length < sizeof(AtlasFileHeader)) return false;
+        std::memcpy(&header, data, sizeof(header));
+        if (header.magic != ATLAS_FILE_MAGIC || header.version != ATLAS_FILE_VERSION ||
+            header.headerSize != sizeof(AtlasFileHeader)) return false;
+        uint64_t tableEnd = (uint64_t)header.glyphOffset + (uint64_t)header.glyphCount * sizeof(AtlasFileGlyph);
+        return header.glyphOffset >= sizeof(AtlasFileHeader) + (uint64_t)header.axisCount * sizeof(AtlasFileAxis) &&
+               tableEnd <= header.pixelOffset &&
+               (uint64_t)header.pixelOffset + header.pixelBytes <= length;
+    }
+}
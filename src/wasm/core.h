@@ -1,11 +1,30 @@
 #pragma once
 
 #include <vector>
+#include <string>
 #include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <memory>
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+// FreeType first: msdfgen-ext.h only declares adoptFreetypeFont when FT_LOAD_DEFAULT is defined
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_MULTIPLE_MASTERS_H
+#include FT_TRUETYPE_TABLES_H
+#include FT_TRUETYPE_TAGS_H
 #include "msdfgen.h"
 #include "msdfgen-ext.h"
+#include "edge_grid.h"
+#include "kerning.h"
+#include "shape_cache.h"
+#include "scratch.h"
+#include "sparse_raster.h"
+#include "stats.h"
 
-// Minimal Core: No atlas packing, no PNG saving. Just Math.
+// Minimal Core: No PNG saving. Just Math. (Atlas packing lives in atlas.h)
 
 namespace msdf_core {
 
@@ -15,456 +34,975 @@ namespace msdf_core {
         double value;   // axis value (e.g., 700.0)
     };
 
-    // Map 4-letter tag to full name for standard axes
-    // Returns nullptr if tag is not a known standard axis
-    inline const char* tagToName(const char* tag) {
-        if (std::strcmp(tag, "wght") == 0) return "Weight";
-        if (std::strcmp(tag, "wdth") == 0) return "Width";
-        if (std::strcmp(tag, "opsz") == 0) return "Optical Size";
-        if (std::strcmp(tag, "ital") == 0) return "Italic";
-        if (std::strcmp(tag, "slnt") == 0) return "Slant";
-        // TODO: For custom axes, we'd need to query the font's name table
-        return nullptr;
-    }
-
-    // Apply variation axes to a loaded font
-    // Returns number of axes successfully set
-    inline int applyVariationAxes(msdfgen::FreetypeHandle* ft, msdfgen::FontHandle* font,
-                                   const VariationAxis* axes, int numAxes) {
-        int successCount = 0;
+    // FreeType / OpenType tag of an axis ("wght" -> FT_MAKE_TAG('w', 'g', 'h', 't'))
+    inline FT_ULong axisTag(const VariationAxis& axis) {
+        return FT_MAKE_TAG((FT_Byte)axis.tag[0], (FT_Byte)axis.tag[1], (FT_Byte)axis.tag[2], (FT_Byte)axis.tag[3]);
+    }
+
+    // Snap an axis value to a multiple of step (step <= 0 keeps it exact), so nearby values share caches
+    inline double quantizeAxisValue(double value, double step) {
+        return step > 0 ? std::round(value / step) * step : value;
+    }
+
+    // Byte string identifying a set of applied axes (empty for the default instance), for cache keys
+    inline std::string axesKey(const VariationAxis* axes, int numAxes) {
+        std::string key;
         for (int i = 0; i < numAxes; ++i) {
-            const char* name = tagToName(axes[i].tag);
-            if (name) {
-                if (msdfgen::setFontVariationAxis(ft, font, name, axes[i].value)) {
-                    successCount++;
-                }
-            }
+            key.append(axes[i].tag, 4);
+            key.append((const char*)&axes[i].value, sizeof(double));
         }
-        return successCount;
+        return key;
     }
 
     /**
-     * Check if a glyph exists in the font (without generating it).
-     * Returns true if the font contains a glyph for this codepoint.
-     * Uses getGlyphIndex which returns 0 for missing glyphs.
+     * 64-bit content hash for persistent cache keys (font bytes, atlas settings); not cryptographic.
+     * FNV-1a over 8-byte words, folded after each word so high bits reach the low ones.
+     * Chain calls through seed to hash several fields.
      */
-    inline bool hasGlyph(const uint8_t* fontBytes, int length, uint32_t charCode) {
-        msdfgen::FreetypeHandle* ft = msdfgen::initializeFreetype();
-        if (!ft) return false;
-
-        msdfgen::FontHandle* font = msdfgen::loadFontData(ft, (msdfgen::byte*)fontBytes, length);
-        if (!font) {
-            msdfgen::deinitializeFreetype(ft);
-            return false;
+    inline uint64_t hashBytes(const void* data, size_t length, uint64_t seed = 0) {
+        const uint8_t* bytes = (const uint8_t*)data;
+        uint64_t h = 0xcbf29ce484222325ull ^ seed;
+        size_t i = 0;
+        for (; i + 8 <= length; i += 8) {
+            uint64_t word;
+            std::memcpy(&word, bytes + i, 8);
+            h = (h ^ word) * 0x100000001b3ull;
+            h ^= h >> 29;
         }
-
-        // Get glyph index - returns 0 if glyph not in font
-        msdfgen::GlyphIndex glyphIndex;
-        bool exists = msdfgen::getGlyphIndex(glyphIndex, font, charCode) && glyphIndex.getIndex() != 0;
-
-        msdfgen::destroyFont(font);
-        msdfgen::deinitializeFreetype(ft);
-        return exists;
+        for (; i < length; ++i) h = (h ^ bytes[i]) * 0x100000001b3ull;
+        h ^= length;
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        return h;
     }
 
+    // Outlines kept per font (see shape_cache.h)
+    static const size_t SHAPE_CACHE_CAPACITY = 4096;
+
     /**
-     * Result of a single glyph generation.
-     * Contains both metric data (for layout) and raw pixel data (for rendering).
+     * An open font, parsed once and reused across glyph calls.
+     * FreeType memory faces reference the font bytes directly, so the session owns them
+     * (or, for per-thread faces, borrows them from the session that does).
      */
-    struct GlyphResult {
-        bool success;           // True if generation succeeded
-        int width;              // Width of the bitmap in pixels
-        int height;             // Height of the bitmap in pixels
-        int channels;           // Number of channels (3 for MSDF, 4 for MTSDF)
-        float advance;          // Horizontal advance (scaled to pixels)
-        float planeBounds[4];   // Physical glyph bounds (L, B, R, T) relative to baseline
-        float atlasBounds[4];   // Texture coordinates (L, B, R, T) - typically 0,0,w,h for single glyph
-        std::vector<float> pixels; // Raw float data (channels * width * height)
+    struct FontSession {
+        FT_Library library;
+        FT_Face face;                       // Owned by the session; font wraps it (adoptFreetypeFont)
+        msdfgen::FontHandle* font;
+        std::vector<uint8_t> bytes;         // Font file data, if owned (must outlive font)
+        uint64_t contentHash = 0;           // hashBytes of the font file, if owned (persistent cache keys)
+        const uint8_t* data;                // Font file data the face was loaded from
+        int length;
+        msdfgen::FontMetrics metrics;       // Font-wide metrics (emSize used for scaling)
+        std::vector<FT_ULong> axisTags;     // Variation axis tags, in FT_MM_Var order
+        std::vector<FT_Fixed> axisDefaults; // Default design coordinate per axis (16.16)
+        std::vector<FT_Fixed> axisCoords;   // Design coordinates last set on the face
+        std::vector<VariationAxis> requestedAxes; // Instance selected by setSessionAxes
+        std::string instanceKey;                // axesKey(requestedAxes), the shape cache key part
+        std::vector<VariationAxis> appliedAxes; // Axes currently set on the face (lags requestedAxes)
+        std::vector<FontSession*> threadFaces;  // Extra faces for worker threads (see thread_pool.h)
+        std::shared_ptr<ShapeCache> shapes;     // Outline cache, shared with threadFaces
+        std::unique_ptr<PairKerning> kerning;   // GPOS kerning, read on first use (see sessionKerning)
     };
 
     /**
-     * Core function to generate a single MSDF glyph (3 channels).
+     * Open a font session over bytes owned by the caller.
+     * Returns nullptr if FreeType fails to initialize or the data is not a font.
      */
-    inline GlyphResult generateOne(const uint8_t* fontBytes, int length, uint32_t charCode, double fontSize, double pixelRange) {
-        GlyphResult result;
-        result.success = false;
-        result.channels = 3;
-
-        // 1. Initialize FreeType
-        msdfgen::FreetypeHandle* ft = msdfgen::initializeFreetype();
-        if (!ft) return result;
+    inline FontSession* openFontView(const uint8_t* data, int length) {
+        FontSession* session = new FontSession();
+        session->data = data;
+        session->length = length;
+
+        if (FT_Init_FreeType(&session->library)) {
+            delete session;
+            return nullptr;
+        }
 
-        // 2. Load Font
-        msdfgen::FontHandle* font = msdfgen::loadFontData(ft, (msdfgen::byte*)fontBytes, length);
-        if (!font) {
-            msdfgen::deinitializeFreetype(ft);
-            return result;
+        // The face is opened here rather than by msdfgen so its variation axes can be driven directly
+        if (FT_New_Memory_Face(session->library, data, length, 0, &session->face)) {
+            FT_Done_FreeType(session->library);
+            delete session;
+            return nullptr;
         }
+        session->font = msdfgen::adoptFreetypeFont(session->face);
 
-        // 3. Load Shape
-        msdfgen::Shape shape;
-        double advance;
-        if (!msdfgen::loadGlyph(shape, font, charCode, &advance)) {
-            msdfgen::destroyFont(font);
-            msdfgen::deinitializeFreetype(ft);
-            return result;
+        msdfgen::getFontMetrics(session->metrics, session->font);
+        session->shapes = std::make_shared<ShapeCache>(SHAPE_CACHE_CAPACITY);
+
+        // Resolve the variation axes once: tags and defaults in the order FT_Set_Var_Design_Coordinates takes
+        FT_MM_Var* mm = nullptr;
+        if (FT_HAS_MULTIPLE_MASTERS(session->face) && !FT_Get_MM_Var(session->face, &mm)) {
+            for (FT_UInt i = 0; i < mm->num_axis; ++i) {
+                session->axisTags.push_back(mm->axis[i].tag);
+                session->axisDefaults.push_back(mm->axis[i].def);
+            }
+            FT_Done_MM_Var(session->library, mm);
         }
+        session->axisCoords = session->axisDefaults;
+        return session;
+    }
 
-        // 4. Edge Coloring
-        shape.normalize();
-        msdfgen::edgeColoringSimple(shape, 3.0);
+    /**
+     * Open a font session. Takes ownership of the font bytes.
+     * Returns nullptr if FreeType fails to initialize or the data is not a font.
+     */
+    inline FontSession* openFont(std::vector<uint8_t>&& bytes) {
+        std::vector<uint8_t> owned = std::move(bytes);
+        FontSession* session = openFontView(owned.data(), (int)owned.size());
+        if (session) {
+            // Moving the vector keeps its heap block, so session->data stays valid
+            session->bytes = std::move(owned);
+            session->contentHash = hashBytes(session->data, (size_t)session->length);
+        }
+        return session;
+    }
 
-        // 5. Bounds & Dimensions
-        double l = 1e240, b = 1e240, r = -1e240, t = -1e240;
-        shape.bound(l, b, r, t);
+    /**
+     * Close a font session (and its per-thread faces) and release FreeType resources.
+     */
+    inline void closeFont(FontSession* session) {
+        if (!session) return;
+        for (FontSession* face : session->threadFaces) {
+            closeFont(face);
+        }
+        msdfgen::destroyFont(session->font); // Adopted: leaves the face to us
+        FT_Done_Face(session->face);
+        FT_Done_FreeType(session->library);
+        delete session;
+    }
 
-        // Handle empty shapes (e.g., space character)
-        if (l >= r || b >= t) {
-            l = b = 0;
-            r = t = 1;
+    inline bool sameAxes(const std::vector<VariationAxis>& a, const VariationAxis* b, int count) {
+        if ((int)a.size() != count) return false;
+        for (int i = 0; i < count; ++i) {
+            if (std::strcmp(a[i].tag, b[i].tag) != 0 || a[i].value != b[i].value) return false;
         }
+        return true;
+    }
 
-        msdfgen::FontMetrics metrics;
-        msdfgen::getFontMetrics(metrics, font);
-        double scale = fontSize / metrics.emSize;
-        
-        double range = pixelRange / 2.0; 
-        double frameL = l * scale - range;
-        double frameB = b * scale - range;
-        double frameR = r * scale + range;
-        double frameT = t * scale + range;
-        
-        int width = (int)ceil(frameR - frameL);
-        int height = (int)ceil(frameT - frameB);
-        
-        double tx = -frameL / scale;
-        double ty = -frameB / scale;
-        
-        msdfgen::Vector2 translate(tx, ty);
-        msdfgen::Vector2 scaling(scale, scale);
-
-        // 6. Generate Bitmap (MSDF)
-        msdfgen::Bitmap<float, 3> msdf(width, height);
-        msdfgen::generateMSDF(msdf, shape, msdfgen::Projection(scaling, translate), pixelRange);
-
-        // 7. Pack Results
-        result.success = true;
-        result.width = width;
-        result.height = height;
-        result.advance = (float)(advance * scale);
-        
-        result.planeBounds[0] = (float)(l * scale);
-        result.planeBounds[1] = (float)(b * scale);
-        result.planeBounds[2] = (float)(r * scale);
-        result.planeBounds[3] = (float)(t * scale);
-        
-        result.atlasBounds[0] = 0;
-        result.atlasBounds[1] = 0;
-        result.atlasBounds[2] = (float)width;
-        result.atlasBounds[3] = (float)height;
-
-        // Copy pixels (3 channels)
-        result.pixels.resize(width * height * 3);
-        for (int y = 0; y < height; ++y) {
-            for (int x = 0; x < width; ++x) {
-                const float* pixel = msdf(x, y);
-                int idx = (y * width + x) * 3;
-                result.pixels[idx + 0] = pixel[0];
-                result.pixels[idx + 1] = pixel[1];
-                result.pixels[idx + 2] = pixel[2];
+    /**
+     * Select the variation instance for the following glyph calls.
+     * Only records the axes: the FreeType face is switched by applySessionAxes once an outline
+     * actually has to be loaded, so instances whose outlines are cached never touch FreeType.
+     * Pass numAxes = 0 for the font's default instance.
+     */
+    inline void setSessionAxes(FontSession& session, const VariationAxis* axes, int numAxes) {
+        if (sameAxes(session.requestedAxes, axes, numAxes)) return;
+        session.requestedAxes.assign(axes, axes + numAxes);
+        session.instanceKey = axesKey(axes, numAxes);
+    }
+
+    /**
+     * Put the session's face into the selected variation instance.
+     * All design coordinates are set in one call, with defaults for axes that were not requested
+     * (tags the font does not have are ignored); nothing is touched if the face is already there.
+     */
+    inline void applySessionAxes(FontSession& session) {
+        const std::vector<VariationAxis>& axes = session.requestedAxes;
+        if (sameAxes(session.appliedAxes, axes.data(), (int)axes.size())) return;
+        session.appliedAxes = axes;
+        if (session.axisTags.empty()) return;
+
+        // One coordinate per font axis: requested values over the defaults, any tag the font has
+        std::vector<FT_Fixed> coords = session.axisDefaults;
+        for (const VariationAxis& axis : axes) {
+            FT_ULong tag = axisTag(axis);
+            for (size_t i = 0; i < session.axisTags.size(); ++i) {
+                if (session.axisTags[i] == tag) {
+                    coords[i] = (FT_Fixed)std::lround(axis.value * 65536.0);
+                    break;
+                }
             }
         }
+        if (coords == session.axisCoords) return;
+        FT_Set_Var_Design_Coordinates(session.face, (FT_UInt)coords.size(), coords.data());
+        session.axisCoords = coords;
+    }
 
-        msdfgen::destroyFont(font);
-        msdfgen::deinitializeFreetype(ft);
-        return result;
+    /**
+     * Check if a glyph exists in the font (without generating it).
+     * Returns true if the font contains a glyph for this codepoint.
+     * Uses getGlyphIndex which returns 0 for missing glyphs.
+     */
+    inline bool hasGlyph(FontSession& session, uint32_t charCode) {
+        msdfgen::GlyphIndex glyphIndex;
+        return msdfgen::getGlyphIndex(glyphIndex, session.font, charCode) && glyphIndex.getIndex() != 0;
+    }
+
+    // Glyph id flag: charCode arguments with bit 31 set carry a glyph index (e.g. shaper output)
+    // instead of a Unicode codepoint, and skip the cmap
+    static const uint32_t GLYPH_INDEX_FLAG = 0x80000000u;
+
+    // Glyph index for a codepoint or flagged glyph index (0 = .notdef for missing codepoints)
+    inline unsigned resolveGlyphIndex(FontSession& session, uint32_t charCode) {
+        if (charCode & GLYPH_INDEX_FLAG) return charCode & ~GLYPH_INDEX_FLAG;
+        msdfgen::GlyphIndex glyphIndex;
+        msdfgen::getGlyphIndex(glyphIndex, session.font, charCode);
+        return glyphIndex.getIndex();
     }
 
     /**
-     * Core function to generate a single MTSDF glyph (4 channels).
+     * Map many codepoints to glyph indices at once (0 where the font has no glyph).
+     * Returns the number of codepoints the font covers.
      */
-    inline GlyphResult generateOneMTSDF(const uint8_t* fontBytes, int length, uint32_t charCode, double fontSize, double pixelRange) {
-        GlyphResult result;
-        result.success = false;
-        result.channels = 4;
+    inline int glyphCoverage(FontSession& session, const uint32_t* codepoints, int count, uint32_t* outIndices) {
+        int covered = 0;
+        for (int i = 0; i < count; ++i) {
+            outIndices[i] = FT_Get_Char_Index(session.face, codepoints[i]);
+            if (outIndices[i] != 0) covered++;
+        }
+        return covered;
+    }
 
-        msdfgen::FreetypeHandle* ft = msdfgen::initializeFreetype();
-        if (!ft) return result;
+    // Font-wide layout metrics in pixels, y up like planeBounds
+    struct LayoutMetrics {
+        double unitsPerEm;          // Font units per em (unscaled)
+        double ascender;            // Baseline to the top of the line, positive
+        double descender;           // Baseline to the bottom of the line, negative
+        double lineHeight;          // Baseline to baseline
+        double underlineY;          // Underline position (usually negative)
+        double underlineThickness;
+    };
 
-        msdfgen::FontHandle* font = msdfgen::loadFontData(ft, (msdfgen::byte*)fontBytes, length);
-        if (!font) {
-            msdfgen::deinitializeFreetype(ft);
-            return result;
+    /**
+     * Line metrics of the selected variation instance at fontSize, on the same
+     * scale as glyph advances and plane bounds.
+     */
+    inline bool layoutMetrics(FontSession& session, double fontSize, LayoutMetrics& out) {
+        applySessionAxes(session); // Variable fonts may vary line metrics (MVAR)
+        msdfgen::FontMetrics metrics;
+        if (!msdfgen::getFontMetrics(metrics, session.font) || metrics.emSize <= 0) return false;
+        double scale = fontSize / metrics.emSize;
+        out.unitsPerEm = session.face->units_per_EM;
+        out.ascender = metrics.ascenderY * scale;
+        out.descender = metrics.descenderY * scale;
+        out.lineHeight = metrics.lineHeight * scale;
+        out.underlineY = metrics.underlineY * scale;
+        out.underlineThickness = metrics.underlineThickness * scale;
+        return true;
+    }
+
+    // The session's GPOS kerning lookups, read from the face the first time they are needed
+    inline const PairKerning& sessionKerning(FontSession& session) {
+        if (!session.kerning) {
+            std::vector<uint8_t> gpos;
+            FT_ULong length = 0;
+            if (!FT_Load_Sfnt_Table(session.face, TTAG_GPOS, 0, nullptr, &length) && length > 0) {
+                gpos.resize(length);
+                if (FT_Load_Sfnt_Table(session.face, TTAG_GPOS, 0, gpos.data(), &length)) gpos.clear();
+            }
+            session.kerning.reset(new PairKerning(std::move(gpos)));
         }
+        return *session.kerning;
+    }
 
-        msdfgen::Shape shape;
-        double advance;
-        if (!msdfgen::loadGlyph(shape, font, charCode, &advance)) {
-            msdfgen::destroyFont(font);
-            msdfgen::deinitializeFreetype(ft);
-            return result;
+    // Kerning of resolved glyph indices in pixels at fontSize: GPOS if the font kerns there, else the 'kern' table
+    inline double glyphKerning(FontSession& session, unsigned first, unsigned second, double fontSize) {
+        if (first == 0 || second == 0 || session.face->units_per_EM == 0) return 0.0;
+        const PairKerning& gpos = sessionKerning(session);
+        if (!gpos.empty()) return gpos.kerning(first, second) * fontSize / session.face->units_per_EM;
+        double value;
+        if (FT_HAS_KERNING(session.face) && session.metrics.emSize > 0 &&
+            msdfgen::getKerning(value, session.font, msdfgen::GlyphIndex(first), msdfgen::GlyphIndex(second))) {
+            return value * fontSize / session.metrics.emSize;
         }
+        return 0.0;
+    }
 
-        shape.normalize();
-        msdfgen::edgeColoringSimple(shape, 3.0);
+    /**
+     * Kerning of a pair in pixels at fontSize, added to the first glyph's advance.
+     * Codes are codepoints or glyph indices with GLYPH_INDEX_FLAG. Kerning tables do not vary
+     * with the instance here: the default instance's values are used.
+     */
+    inline double pairKerning(FontSession& session, uint32_t first, uint32_t second, double fontSize) {
+        return glyphKerning(session, resolveGlyphIndex(session, first), resolveGlyphIndex(session, second), fontSize);
+    }
 
-        double l = 1e240, b = 1e240, r = -1e240, t = -1e240;
-        shape.bound(l, b, r, t);
+    /**
+     * Every ordered pair of a charset with nonzero kerning, row by row (first code in input order).
+     * Writes up to maxPairs pairs (2 codes each) and amounts; returns the total, which may be larger.
+     */
+    inline int kerningTable(FontSession& session, const uint32_t* codes, int count, double fontSize,
+                            uint32_t* outPairs, float* outAmounts, int maxPairs) {
+        std::vector<unsigned> glyphs(count);
+        for (int i = 0; i < count; ++i) glyphs[i] = resolveGlyphIndex(session, codes[i]);
+        const PairKerning& gpos = sessionKerning(session);
+
+        int total = 0;
+        for (int i = 0; i < count; ++i) {
+            if (glyphs[i] == 0 || (!gpos.empty() && !gpos.coversFirst(glyphs[i]))) continue;
+            for (int j = 0; j < count; ++j) {
+                double amount = glyphKerning(session, glyphs[i], glyphs[j], fontSize);
+                if (amount == 0.0) continue;
+                if (total < maxPairs) {
+                    outPairs[total * 2] = codes[i];
+                    outPairs[total * 2 + 1] = codes[j];
+                    outAmounts[total] = (float)amount;
+                }
+                total++;
+            }
+        }
+        return total;
+    }
 
-        // Handle empty shapes (e.g., space character)
-        if (l >= r || b >= t) {
-            l = b = 0;
-            r = t = 1;
+    // Distance field type for calls that pick the type at runtime (batch generation)
+    enum GlyphMode {
+        MODE_MSDF = 0,  // 3 channels
+        MODE_MTSDF = 1, // 4 channels
+        MODE_SDF = 2    // 1 channel: true signed distance, for shadows and glows
+    };
+
+    inline int modeChannels(int mode) {
+        switch (mode) {
+        case MODE_MTSDF: return 4;
+        case MODE_SDF: return 1;
+        default: return 3;
         }
+    }
 
-        msdfgen::FontMetrics metrics;
-        msdfgen::getFontMetrics(metrics, font);
-        double scale = fontSize / metrics.emSize;
+    /**
+     * Rasterization precision.
+     * msdfgen's geometry is double throughout, so the fast path trades accuracy through its
+     * generator options instead: contour overlap handling is dropped for outlines shown to
+     * be overlap-free (outlineMayOverlap), and error correction skips its exact distance check.
+     */
+    enum Precision {
+        PRECISION_EXACT = 0,    // msdfgen defaults (overlap support, distance-checked error correction)
+        PRECISION_FAST = 1      // Simple contour combiner where safe, error correction without distance checks
+    };
 
-        double range = pixelRange / 2.0;
-        double frameL = l * scale - range;
-        double frameB = b * scale - range;
-        double frameR = r * scale + range;
-        double frameT = t * scale + range;
+    // Build-wide default (make PRECISION=fast); the bindings let callers override it per generator
+#ifdef MSDF_FAST_PRECISION
+    static const int DEFAULT_PRECISION = PRECISION_FAST;
+#else
+    static const int DEFAULT_PRECISION = PRECISION_EXACT;
+#endif
 
-        int width = (int)ceil(frameR - frameL);
-        int height = (int)ceil(frameT - frameB);
+    /**
+     * Error correction policy for MSDF / MTSDF output (SDF output has no corners to correct).
+     * msdfgen's correction pass can re-evaluate distances for many texels, so previews may
+     * take the cheaper edge-only pass and baked atlases the full one.
+     */
+    enum ErrorCorrection {
+        CORRECTION_PRECISION = 0,   // As the precision selects (default)
+        CORRECTION_OFF = 1,         // No correction pass
+        CORRECTION_EDGE_ONLY = 2,   // Only texels next to edges, without distance checks
+        CORRECTION_FULL = 3,        // Every texel that may hold an artifact, always distance checked
+        CORRECTION_AUTO = 4         // None for outlines without corners, else as the precision selects
+    };
 
-        double tx = -frameL / scale;
-        double ty = -frameB / scale;
+    // How a prepared glyph is rasterized; part of the glyph cache key
+    struct RasterOptions {
+        int precision = DEFAULT_PRECISION;      // Precision
+        bool sparse = false;                    // Distances only near edges, saturated far field (renderSparse)
+        bool grid = false;                      // Per-tile contour culling for complex outlines (ContourCuller)
+        int correction = CORRECTION_PRECISION;  // ErrorCorrection
 
-        msdfgen::Vector2 translate(tx, ty);
-        msdfgen::Vector2 scaling(scale, scale);
+        int key() const {
+            return precision | (sparse ? 2 : 0) | (grid ? 4 : 0) | correction << 3;
+        }
+    };
 
-        // 6. Generate Bitmap (MTSDF)
-        msdfgen::Bitmap<float, 4> msdf(width, height);
-        msdfgen::generateMTSDF(msdf, shape, msdfgen::Projection(scaling, translate), pixelRange);
+    // Output sample type
+    enum PixelFormat {
+        FORMAT_FLOAT32 = 0, // Raw distance samples (0.5 = edge)
+        FORMAT_UINT8 = 1    // Quantized, upload-ready (RGB8 / RGBA8)
+    };
 
-        result.success = true;
-        result.width = width;
-        result.height = height;
-        result.advance = (float)(advance * scale);
-        
-        result.planeBounds[0] = (float)(l * scale);
-        result.planeBounds[1] = (float)(b * scale);
-        result.planeBounds[2] = (float)(r * scale);
-        result.planeBounds[3] = (float)(t * scale);
-        
-        result.atlasBounds[0] = 0;
-        result.atlasBounds[1] = 0;
-        result.atlasBounds[2] = (float)width;
-        result.atlasBounds[3] = (float)height;
-
-        // Copy pixels (4 channels)
-        result.pixels.resize(width * height * 4);
-        for (int y = 0; y < height; ++y) {
-            for (int x = 0; x < width; ++x) {
-                const float* pixel = msdf(x, y);
-                int idx = (y * width + x) * 4;
-                result.pixels[idx + 0] = pixel[0];
-                result.pixels[idx + 1] = pixel[1];
-                result.pixels[idx + 2] = pixel[2];
-                result.pixels[idx + 3] = pixel[3];
+    /**
+     * Quantize distance samples to bytes.
+     * Samples are clamped to 0..1 (the pixel range around the edge) and mapped to 0..255,
+     * rounding like msdfgen's pixelFloatToByte, so 0.5 (the edge) becomes 128.
+     */
+    inline void quantizePixels(const float* src, uint8_t* dst, size_t count) {
+        size_t i = 0;
+#ifdef __wasm_simd128__
+        // 16 samples per step: clamp, scale, truncate, then narrow i32 -> u16 -> u8
+        const v128_t zero = wasm_f32x4_splat(0.0f);
+        const v128_t one = wasm_f32x4_splat(1.0f);
+        const v128_t scale = wasm_f32x4_splat(255.0f);
+        const v128_t half = wasm_f32x4_splat(0.5f);
+        for (; i + 16 <= count; i += 16) {
+            v128_t q[4];
+            for (int k = 0; k < 4; ++k) {
+                v128_t v = wasm_v128_load(src + i + k * 4);
+                v = wasm_f32x4_pmin(wasm_f32x4_pmax(v, zero), one);
+                q[k] = wasm_i32x4_trunc_sat_f32x4(wasm_f32x4_add(wasm_f32x4_mul(v, scale), half));
             }
+            v128_t lo = wasm_u16x8_narrow_i32x4(q[0], q[1]);
+            v128_t hi = wasm_u16x8_narrow_i32x4(q[2], q[3]);
+            wasm_v128_store(dst + i, wasm_u8x16_narrow_i16x8(lo, hi));
+        }
+#endif
+        for (; i < count; ++i) {
+            float v = src[i];
+            v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+            dst[i] = (uint8_t)(v * 255.0f + 0.5f);
         }
-
-        msdfgen::destroyFont(font);
-        msdfgen::deinitializeFreetype(ft);
-        return result;
     }
 
     /**
-     * Generate MSDF glyph with variation axes (3 channels).
+     * Result of a single glyph generation.
+     * Contains both metric data (for layout) and raw pixel data (for rendering).
      */
-    inline GlyphResult generateOneVar(const uint8_t* fontBytes, int length, uint32_t charCode,
-                                       double fontSize, double pixelRange,
-                                       const VariationAxis* axes, int numAxes) {
-        GlyphResult result;
-        result.success = false;
-        result.channels = 3;
+    struct GlyphResult {
+        bool success;           // True if generation succeeded
+        int width;              // Width of the bitmap in pixels
+        int height;             // Height of the bitmap in pixels
+        int channels;           // Number of channels (1 for SDF, 3 for MSDF, 4 for MTSDF)
+        float advance;          // Horizontal advance (scaled to pixels)
+        float planeBounds[4];   // Physical glyph bounds (L, B, R, T) relative to baseline
+        float atlasBounds[4];   // Texture coordinates (L, B, R, T) - typically 0,0,w,h for single glyph
+        std::vector<float> pixels; // Raw float data (channels * width * height)
+    };
 
-        msdfgen::FreetypeHandle* ft = msdfgen::initializeFreetype();
-        if (!ft) return result;
+    /**
+     * A glyph loaded and edge-colored, with its output frame computed but not yet rendered.
+     * Lets callers pick the output location (e.g. a slot in an atlas) before rasterizing.
+     */
+    struct GlyphGeometry {
+        std::shared_ptr<const CachedShape> outline; // Normalized, edge-colored outline (shared with the shape cache)
+        bool empty;                 // True for glyphs with no outline (e.g., space)
+        double advance;             // Horizontal advance (font units)
+        double l, b, r, t;          // Shape bounds (font units)
+        double scale;               // Pixels per font unit
+        double frameL, frameB;      // Bottom-left corner of the bitmap relative to the origin (pixels)
+        int width;                  // Bitmap width in pixels (including range padding)
+        int height;                 // Bitmap height in pixels (including range padding)
+        msdfgen::Vector2 translate; // Projection translation (font units)
+#ifdef MSDF_STATS
+        GlyphStats stats;           // Load / coloring timings so far (see stats.h)
+#endif
+    };
 
-        msdfgen::FontHandle* font = msdfgen::loadFontData(ft, (msdfgen::byte*)fontBytes, length);
-        if (!font) {
-            msdfgen::deinitializeFreetype(ft);
-            return result;
+    /**
+     * Overlap heuristic for the fast path: false only if every pair of contours is
+     * either disjoint (by bounding box) or nested with opposite winding (an outline and its hole).
+     */
+    inline bool outlineMayOverlap(const msdfgen::Shape& shape) {
+        size_t n = shape.contours.size();
+        std::vector<double> box(n * 4);
+        std::vector<int> winding(n);
+        for (size_t i = 0; i < n; ++i) {
+            double* bi = &box[i * 4];
+            bi[0] = bi[1] = 1e240;
+            bi[2] = bi[3] = -1e240;
+            shape.contours[i].bound(bi[0], bi[1], bi[2], bi[3]);
+            winding[i] = shape.contours[i].winding();
         }
-
-        // Apply variation axes before loading glyph
-        if (numAxes > 0) {
-            applyVariationAxes(ft, font, axes, numAxes);
+        for (size_t i = 0; i < n; ++i) {
+            const double* a = &box[i * 4];
+            for (size_t j = i + 1; j < n; ++j) {
+                const double* b = &box[j * 4];
+                if (a[2] <= b[0] || b[2] <= a[0] || a[3] <= b[1] || b[3] <= a[1]) continue;
+                bool nested = (a[0] <= b[0] && a[1] <= b[1] && a[2] >= b[2] && a[3] >= b[3]) ||
+                              (b[0] <= a[0] && b[1] <= a[1] && b[2] >= a[2] && b[3] >= a[3]);
+                if (nested && winding[i] * winding[j] < 0) continue;
+                return true;
+            }
         }
+        return false;
+    }
 
-        msdfgen::Shape shape;
-        double advance;
-        if (!msdfgen::loadGlyph(shape, font, charCode, &advance)) {
-            msdfgen::destroyFont(font);
-            msdfgen::deinitializeFreetype(ft);
-            return result;
+    /**
+     * True if edge coloring found a corner. Contours without one stay white, so all three
+     * channels hold the same pseudo-distance and error correction has nothing to fix.
+     */
+    inline bool outlineHasCorners(const msdfgen::Shape& shape) {
+        for (const msdfgen::Contour& contour : shape.contours) {
+            for (const msdfgen::EdgeHolder& edge : contour.edges) {
+                if (edge->color != msdfgen::WHITE) return true;
+            }
         }
+        return false;
+    }
 
-        shape.normalize();
-        msdfgen::edgeColoringSimple(shape, 3.0);
-
-        double l = 1e240, b = 1e240, r = -1e240, t = -1e240;
+    /**
+     * Bounds of a normalized outline (font units). Returns true for empty outlines
+     * (e.g., space), whose bounds are set to 0, 0, 1, 1.
+     */
+    inline bool boundOutline(const msdfgen::Shape& shape, double& l, double& b, double& r, double& t) {
+        l = b = 1e240;
+        r = t = -1e240;
         shape.bound(l, b, r, t);
-
-        // Handle empty shapes (e.g., space character)
-        if (l >= r || b >= t) {
+        bool empty = l >= r || b >= t;
+        if (empty) {
             l = b = 0;
             r = t = 1;
         }
+        return empty;
+    }
 
-        msdfgen::FontMetrics metrics;
-        msdfgen::getFontMetrics(metrics, font);
-        double scale = fontSize / metrics.emSize;
+    /**
+     * Load, normalize and edge-color a glyph outline with the session's current axes,
+     * or reuse it from the session's shape cache. Returns nullptr if the glyph fails to load.
+     * charCode is a codepoint or a glyph index with GLYPH_INDEX_FLAG.
+     * stats (MSDF_STATS builds only) receives the load and coloring times.
+     */
+    inline std::shared_ptr<const CachedShape> loadOutline(FontSession& session, uint32_t charCode,
+                                                          GlyphStats* stats = nullptr) {
+        (void)stats;
+        // Missing codepoints map to glyph 0 (.notdef), as with loadGlyph by codepoint
+        msdfgen::GlyphIndex glyphIndex(resolveGlyphIndex(session, charCode));
+
+        const std::string& axes = session.instanceKey;
+        if (session.shapes) {
+            std::shared_ptr<const CachedShape> cached = session.shapes->find(glyphIndex.getIndex(), axes);
+            if (cached) {
+#ifdef MSDF_STATS
+                if (stats) stats->flags |= STATS_SHAPE_CACHED;
+#endif
+                return cached;
+            }
+        }
+
+#ifdef MSDF_STATS
+        StatsTimer timer;
+#endif
+        applySessionAxes(session);
+        std::shared_ptr<CachedShape> outline = std::make_shared<CachedShape>();
+        if (!msdfgen::loadGlyph(outline->shape, session.font, glyphIndex, &outline->advance)) {
+            return nullptr;
+        }
+#ifdef MSDF_STATS
+        if (stats) stats->loadUs = timer.lapUs();
+#endif
+
+        outline->shape.normalize();
+        // Bounded before edge coloring, which can split edges again: measureGlyph bounds the same normalized shape
+        outline->empty = boundOutline(outline->shape, outline->l, outline->b, outline->r, outline->t);
+        msdfgen::edgeColoringSimple(outline->shape, 3.0);
+#ifdef MSDF_STATS
+        if (stats) stats->coloringUs = timer.lapUs();
+#endif
+
+        outline->mayOverlap = outlineMayOverlap(outline->shape);
+        outline->hasCorners = outlineHasCorners(outline->shape);
+        buildEdgeIndex(outline->shape, outline->edges);
+
+        if (session.shapes) session.shapes->insert(glyphIndex.getIndex(), axes, outline);
+        return outline;
+    }
+
+    /**
+     * Output frame of a glyph from its outline bounds (font units); the frame math shared by
+     * every generate path and measureGlyph. Leaves out.outline untouched.
+     */
+    inline void frameGlyph(const FontSession& session, double l, double b, double r, double t, double advance,
+                           bool empty, double fontSize, double pixelRange, GlyphGeometry& out) {
+        out.empty = empty;
+        out.advance = advance;
+        out.l = l;
+        out.b = b;
+        out.r = r;
+        out.t = t;
+
+        out.scale = fontSize / session.metrics.emSize;
 
         double range = pixelRange / 2.0;
-        double frameL = l * scale - range;
-        double frameB = b * scale - range;
-        double frameR = r * scale + range;
-        double frameT = t * scale + range;
+        out.frameL = l * out.scale - range;
+        out.frameB = b * out.scale - range;
+        double frameR = r * out.scale + range;
+        double frameT = t * out.scale + range;
+
+        out.width = (int)ceil(frameR - out.frameL);
+        out.height = (int)ceil(frameT - out.frameB);
+        out.translate = msdfgen::Vector2(-out.frameL / out.scale, -out.frameB / out.scale);
+    }
 
-        int width = (int)ceil(frameR - frameL);
-        int height = (int)ceil(frameT - frameB);
+    /**
+     * Load (or reuse), color and measure a glyph with the session's current axes.
+     * charCode is a codepoint or a glyph index with GLYPH_INDEX_FLAG. Same frame math as generateOne.
+     */
+    inline bool prepareGlyph(FontSession& session, uint32_t charCode, double fontSize, double pixelRange,
+                             GlyphGeometry& out) {
+#ifdef MSDF_STATS
+        out.stats = GlyphStats();
+        out.stats.codepoint = charCode;
+        out.outline = loadOutline(session, charCode, &out.stats);
+#else
+        out.outline = loadOutline(session, charCode);
+#endif
+        if (!out.outline) return false;
+
+        const CachedShape& outline = *out.outline;
+        frameGlyph(session, outline.l, outline.b, outline.r, outline.t, outline.advance, outline.empty,
+                   fontSize, pixelRange, out);
+#ifdef MSDF_STATS
+        out.stats.width = out.width;
+        out.stats.height = out.height;
+#endif
+        return true;
+    }
 
-        double tx = -frameL / scale;
-        double ty = -frameB / scale;
+    // A prepared glyph at another size: the same outline (nothing is loaded or colored) in a new frame
+    inline void resizeGlyph(const FontSession& session, const GlyphGeometry& base, double fontSize, double pixelRange,
+                            GlyphGeometry& out) {
+        out.outline = base.outline;
+        frameGlyph(session, base.l, base.b, base.r, base.t, base.advance, base.empty, fontSize, pixelRange, out);
+#ifdef MSDF_STATS
+        out.stats = GlyphStats();
+        out.stats.codepoint = base.stats.codepoint;
+        out.stats.flags = STATS_SHAPE_CACHED;
+        out.stats.width = out.width;
+        out.stats.height = out.height;
+#endif
+    }
 
-        msdfgen::Vector2 translate(tx, ty);
-        msdfgen::Vector2 scaling(scale, scale);
+    /**
+     * The metrics of prepareGlyph without anything needed only to rasterize: a cached outline
+     * is reused, otherwise the glyph is loaded and bounded but neither edge-colored nor
+     * cached, so glyphs that are never drawn cost one FreeType load. out.outline stays empty
+     * (the geometry cannot be rendered); every other field matches prepareGlyph.
+     */
+    inline bool measureGlyph(FontSession& session, uint32_t charCode, double fontSize, double pixelRange,
+                             GlyphGeometry& out) {
+        msdfgen::GlyphIndex glyphIndex(resolveGlyphIndex(session, charCode));
+        out.outline = nullptr;
+        if (session.shapes) {
+            std::shared_ptr<const CachedShape> cached = session.shapes->find(glyphIndex.getIndex(), session.instanceKey);
+            if (cached) {
+                frameGlyph(session, cached->l, cached->b, cached->r, cached->t, cached->advance, cached->empty,
+                           fontSize, pixelRange, out);
+                return true;
+            }
+        }
 
-        msdfgen::Bitmap<float, 3> msdf(width, height);
-        msdfgen::generateMSDF(msdf, shape, msdfgen::Projection(scaling, translate), pixelRange);
+        applySessionAxes(session);
+        msdfgen::Shape shape;
+        double advance = 0;
+        if (!msdfgen::loadGlyph(shape, session.font, glyphIndex, &advance)) return false;
+        shape.normalize(); // The shape loadOutline bounds, ahead of its edge coloring, so the bounds match bit for bit
+        double l, b, r, t;
+        bool empty = boundOutline(shape, l, b, r, t);
+        frameGlyph(session, l, b, r, t, advance, empty, fontSize, pixelRange, out);
+        return true;
+    }
 
-        result.success = true;
-        result.width = width;
-        result.height = height;
-        result.advance = (float)(advance * scale);
+    // msdfgen error correction options for a policy (see ErrorCorrection)
+    inline msdfgen::ErrorCorrectionConfig correctionConfig(const GlyphGeometry& glyph, const RasterOptions& options) {
+        typedef msdfgen::ErrorCorrectionConfig EC;
+        int policy = options.correction;
+        if (policy == CORRECTION_AUTO) policy = glyph.outline->hasCorners ? CORRECTION_PRECISION : CORRECTION_OFF;
+        switch (policy) {
+        case CORRECTION_OFF: return EC(EC::DISABLED);
+        case CORRECTION_EDGE_ONLY: return EC(EC::EDGE_ONLY, EC::DO_NOT_CHECK_DISTANCE);
+        case CORRECTION_FULL: return EC(EC::EDGE_PRIORITY, EC::ALWAYS_CHECK_DISTANCE);
+        default:
+            if (options.precision == PRECISION_FAST) return EC(EC::EDGE_PRIORITY, EC::DO_NOT_CHECK_DISTANCE);
+            return EC();
+        }
+    }
 
-        result.planeBounds[0] = (float)(l * scale);
-        result.planeBounds[1] = (float)(b * scale);
-        result.planeBounds[2] = (float)(r * scale);
-        result.planeBounds[3] = (float)(t * scale);
+    // msdfgen generator options for a precision (see Precision) and error correction policy
+    inline msdfgen::MSDFGeneratorConfig generatorConfig(const GlyphGeometry& glyph, const RasterOptions& options) {
+        bool overlapSupport = options.precision == PRECISION_FAST ? glyph.outline->mayOverlap : true;
+        return msdfgen::MSDFGeneratorConfig(overlapSupport, correctionConfig(glyph, options));
+    }
 
-        result.atlasBounds[0] = 0;
-        result.atlasBounds[1] = 0;
-        result.atlasBounds[2] = (float)width;
-        result.atlasBounds[3] = (float)height;
-
-        result.pixels.resize(width * height * 3);
-        for (int y = 0; y < height; ++y) {
-            for (int x = 0; x < width; ++x) {
-                const float* pixel = msdf(x, y);
-                int idx = (y * width + x) * 3;
-                result.pixels[idx + 0] = pixel[0];
-                result.pixels[idx + 1] = pixel[1];
-                result.pixels[idx + 2] = pixel[2];
+    // Rasterize a prepared glyph into any bitmap region of matching size
+    template <int N>
+    inline void renderGlyph(const msdfgen::BitmapSection<float, N>& output, const GlyphGeometry& glyph, double pixelRange,
+                            const RasterOptions& options = RasterOptions()) {
+        msdfgen::MSDFGeneratorConfig config = generatorConfig(glyph, options);
+        if (N > 1 && config.errorCorrection.mode != msdfgen::ErrorCorrectionConfig::DISABLED) {
+            config.errorCorrection.buffer = glyphScratch().stencil((size_t)output.width * output.height);
+        }
+        if (options.grid && glyph.outline->edges.usable()) {
+            ContourCuller culler(glyph.outline->shape, glyph.outline->edges);
+            if (options.sparse) {
+                renderSparse(output, glyph.outline->shape, glyph.scale, glyph.translate, pixelRange, config, &culler);
+            } else {
+                culler.generate(output, glyph.scale, glyph.translate, pixelRange, config);
             }
+            return;
         }
-
-        msdfgen::destroyFont(font);
-        msdfgen::deinitializeFreetype(ft);
-        return result;
+        if (options.sparse) {
+            renderSparse(output, glyph.outline->shape, glyph.scale, glyph.translate, pixelRange, config);
+            return;
+        }
+        msdfgen::Vector2 scaling(glyph.scale, glyph.scale);
+        generateSection(output, glyph.outline->shape, msdfgen::Projection(scaling, glyph.translate), pixelRange, config);
     }
 
     /**
-     * Generate MTSDF glyph with variation axes (4 channels).
+     * Caller-owned destination region: width x height pixels, rows rowStride samples apart
+     * (0 = tightly packed), samples stored as float or uint8 per format.
+     * Row 0 receives the bottom row of the glyph, or its top row with topDown.
+     * channels = 4 stores 3-channel output as RGBA with an opaque alpha; 0 keeps the rendered count.
      */
-    inline GlyphResult generateOneMTSDFVar(const uint8_t* fontBytes, int length, uint32_t charCode,
-                                            double fontSize, double pixelRange,
-                                            const VariationAxis* axes, int numAxes) {
-        GlyphResult result;
-        result.success = false;
-        result.channels = 4;
+    struct PixelTarget {
+        void* data;
+        int width;
+        int height;
+        int rowStride;
+        int format;
+        int channels = 0;
+        bool topDown = false;
+    };
 
-        msdfgen::FreetypeHandle* ft = msdfgen::initializeFreetype();
-        if (!ft) return result;
+    // Largest row alignment OutputLayout accepts, in bytes
+    static const int LAYOUT_MAX_ROW_ALIGN = 4096;
 
-        msdfgen::FontHandle* font = msdfgen::loadFontData(ft, (msdfgen::byte*)fontBytes, length);
-        if (!font) {
-            msdfgen::deinitializeFreetype(ft);
-            return result;
+    /**
+     * Memory layout of generated pixels; part of the glyph cache key. The default is
+     * msdfgen's: rows bottom to top, tightly packed, the mode's channels. GPU uploads
+     * usually want rows top to bottom, row starts on a 256-byte boundary (WebGPU
+     * bytesPerRow) and MSDF as RGBA (there is no 3-channel 8-bit texture format).
+     */
+    struct OutputLayout {
+        bool topDown = false;   // Row 0 is the top row
+        int rowAlign = 1;       // Row starts are multiples of this many bytes (power of two)
+        bool padAlpha = false;  // 3-channel output stored as RGBA, alpha 1.0 / 255
+
+        int key() const {
+            int shift = 0;
+            while ((1 << shift) < rowAlign) ++shift;
+            return (topDown ? 1 : 0) | (padAlpha ? 2 : 0) | shift << 2;
         }
 
-        // Apply variation axes before loading glyph
-        if (numAxes > 0) {
-            applyVariationAxes(ft, font, axes, numAxes);
+        // Channels per stored pixel for a mode with this many channels
+        int storedChannels(int channels) const {
+            return padAlpha && channels == 3 ? 4 : channels;
         }
 
-        msdfgen::Shape shape;
-        double advance;
-        if (!msdfgen::loadGlyph(shape, font, charCode, &advance)) {
-            msdfgen::destroyFont(font);
-            msdfgen::deinitializeFreetype(ft);
-            return result;
+        // Samples from one row start to the next
+        int rowStride(int width, int channels, int format) const {
+            size_t sample = format == FORMAT_UINT8 ? 1 : sizeof(float);
+            size_t bytes = (size_t)width * storedChannels(channels) * sample;
+            size_t align = rowAlign > 1 ? (size_t)rowAlign : 1;
+            return (int)((bytes + align - 1) / align * align / sample);
         }
 
-        shape.normalize();
-        msdfgen::edgeColoringSimple(shape, 3.0);
-
-        double l = 1e240, b = 1e240, r = -1e240, t = -1e240;
-        shape.bound(l, b, r, t);
-
-        // Handle empty shapes (e.g., space character)
-        if (l >= r || b >= t) {
-            l = b = 0;
-            r = t = 1;
+        // Target for a region of this layout at data
+        PixelTarget target(void* data, int width, int height, int channels, int format) const {
+            PixelTarget result;
+            result.data = data;
+            result.width = width;
+            result.height = height;
+            result.rowStride = rowStride(width, channels, format);
+            result.format = format;
+            result.channels = storedChannels(channels);
+            result.topDown = topDown;
+            return result;
         }
+    };
 
-        msdfgen::FontMetrics metrics;
-        msdfgen::getFontMetrics(metrics, font);
-        double scale = fontSize / metrics.emSize;
+    /**
+     * Widen a quantized row of RGB pixels to RGBA in place (alpha 255). The RGB samples fill
+     * the first 3 * pixels bytes of a row with room for 4 * pixels.
+     */
+    inline void padPixels(uint8_t* row, int pixels) {
+        // Back to front, so no pixel is overwritten before it moves
+        for (int x = pixels - 1; x >= 0; --x) {
+            row[x * 4 + 3] = 255;
+            row[x * 4 + 2] = row[x * 3 + 2];
+            row[x * 4 + 1] = row[x * 3 + 1];
+            row[x * 4 + 0] = row[x * 3 + 0];
+        }
+    }
 
-        double range = pixelRange / 2.0;
-        double frameL = l * scale - range;
-        double frameB = b * scale - range;
-        double frameR = r * scale + range;
-        double frameT = t * scale + range;
+    /**
+     * Rasterize a prepared glyph through the thread's scratch bitmap, then write it row by row
+     * into a target msdfgen cannot render into directly: bytes (quantized), rows top to bottom,
+     * or 3-channel samples widened to 4 (see PixelTarget::channels).
+     * @param stored Channels per pixel in the target (N, or 4 for padded 3-channel output)
+     */
+    template <int N>
+    inline void renderGlyphPacked(const PixelTarget& target, int rowStride, int stored, const GlyphGeometry& glyph,
+                                  double pixelRange, const RasterOptions& options = RasterOptions(),
+                                  GlyphStats* stats = nullptr) {
+        (void)stats;
+#ifdef MSDF_STATS
+        StatsTimer timer;
+#endif
+        msdfgen::BitmapSection<float, N> bitmap(
+            glyphScratch().samples((size_t)glyph.width * glyph.height * N), glyph.width, glyph.height);
+        renderGlyph<N>(bitmap, glyph, pixelRange, options);
+#ifdef MSDF_STATS
+        if (stats) stats->rasterUs = timer.lapUs();
+#endif
+        size_t rowSamples = (size_t)glyph.width * N;
+        for (int y = 0; y < glyph.height; ++y) {
+            const float* src = bitmap(0, y);
+            size_t row = (size_t)(target.topDown ? glyph.height - 1 - y : y) * rowStride;
+            if (target.format == FORMAT_UINT8) {
+                uint8_t* dst = (uint8_t*)target.data + row;
+                quantizePixels(src, dst, rowSamples);
+                if (stored != N) padPixels(dst, glyph.width);
+            } else {
+                float* dst = (float*)target.data + row;
+                if (stored == N) {
+                    std::memcpy(dst, src, rowSamples * sizeof(float));
+                } else {
+                    for (int x = 0; x < glyph.width; ++x) {
+                        dst[x * 4 + 0] = src[x * 3 + 0];
+                        dst[x * 4 + 1] = src[x * 3 + 1];
+                        dst[x * 4 + 2] = src[x * 3 + 2];
+                        dst[x * 4 + 3] = 1.0f;
+                    }
+                }
+            }
+        }
+#ifdef MSDF_STATS
+        if (stats) stats->packUs = timer.lapUs();
+#endif
+    }
 
-        int width = (int)ceil(frameR - frameL);
-        int height = (int)ceil(frameT - frameB);
+    // True if msdfgen can render a glyph of this many channels straight into the target
+    inline bool rendersInPlace(const PixelTarget& target, int channels) {
+        return target.format == FORMAT_FLOAT32 && !target.topDown && target.channels <= channels;
+    }
 
-        double tx = -frameL / scale;
-        double ty = -frameB / scale;
+    // Render N channels into a target of either format and layout; rowStride in samples
+    template <int N>
+    inline void renderTarget(const PixelTarget& target, int rowStride, const GlyphGeometry& glyph, double pixelRange,
+                             const RasterOptions& options, GlyphStats* stats) {
+        if (rendersInPlace(target, N)) {
+            msdfgen::BitmapSection<float, N> section((float*)target.data, glyph.width, glyph.height, rowStride);
+            renderGlyph<N>(section, glyph, pixelRange, options);
+        } else {
+            int stored = target.channels > N ? target.channels : N;
+            renderGlyphPacked<N>(target, rowStride, stored, glyph, pixelRange, options, stats);
+        }
+    }
 
-        msdfgen::Vector2 translate(tx, ty);
-        msdfgen::Vector2 scaling(scale, scale);
+    /**
+     * Rasterize a prepared glyph straight into a target (no intermediate copy for float output
+     * in the default layout).
+     * Returns false, writing nothing, if the glyph does not fit the target region.
+     */
+    inline bool renderInto(const PixelTarget& target, int channels, const GlyphGeometry& glyph, double pixelRange,
+                           const RasterOptions& options = RasterOptions()) {
+        if (!target.data || glyph.width > target.width || glyph.height > target.height) return false;
+        int stored = target.channels > channels ? target.channels : channels;
+        int rowStride = target.rowStride > 0 ? target.rowStride : glyph.width * stored;
+#ifdef MSDF_STATS
+        GlyphStats record = glyph.stats;
+        record.channels = channels;
+        GlyphStats* stats = &record;
+        StatsTimer timer;
+#else
+        GlyphStats* stats = nullptr;
+#endif
+
+        switch (channels) {
+        case 1: renderTarget<1>(target, rowStride, glyph, pixelRange, options, stats); break;
+        case 4: renderTarget<4>(target, rowStride, glyph, pixelRange, options, stats); break;
+        default: renderTarget<3>(target, rowStride, glyph, pixelRange, options, stats); break;
+        }
 
-        msdfgen::Bitmap<float, 4> msdf(width, height);
-        msdfgen::generateMTSDF(msdf, shape, msdfgen::Projection(scaling, translate), pixelRange);
+#ifdef MSDF_STATS
+        if (target.format == FORMAT_UINT8) record.flags |= STATS_UINT8;
+        if (rendersInPlace(target, channels)) record.rasterUs = timer.lapUs(); // Nothing to pack
+        record.allocBytes += (uint32_t)glyphScratch().takeGrowth();
+        statsRing().record(record);
+#endif
+        return true;
+    }
 
+    // Fill the metric fields of a result from a prepared glyph (pixels are left untouched)
+    inline void fillMetrics(GlyphResult& result, const GlyphGeometry& glyph, int channels) {
         result.success = true;
-        result.width = width;
-        result.height = height;
-        result.advance = (float)(advance * scale);
+        result.width = glyph.width;
+        result.height = glyph.height;
+        result.channels = channels;
+        result.advance = (float)(glyph.advance * glyph.scale);
 
-        result.planeBounds[0] = (float)(l * scale);
-        result.planeBounds[1] = (float)(b * scale);
-        result.planeBounds[2] = (float)(r * scale);
-        result.planeBounds[3] = (float)(t * scale);
+        result.planeBounds[0] = (float)(glyph.l * glyph.scale);
+        result.planeBounds[1] = (float)(glyph.b * glyph.scale);
+        result.planeBounds[2] = (float)(glyph.r * glyph.scale);
+        result.planeBounds[3] = (float)(glyph.t * glyph.scale);
 
         result.atlasBounds[0] = 0;
         result.atlasBounds[1] = 0;
-        result.atlasBounds[2] = (float)width;
-        result.atlasBounds[3] = (float)height;
-
-        result.pixels.resize(width * height * 4);
-        for (int y = 0; y < height; ++y) {
-            for (int x = 0; x < width; ++x) {
-                const float* pixel = msdf(x, y);
-                int idx = (y * width + x) * 4;
-                result.pixels[idx + 0] = pixel[0];
-                result.pixels[idx + 1] = pixel[1];
-                result.pixels[idx + 2] = pixel[2];
-                result.pixels[idx + 3] = pixel[3];
-            }
-        }
+        result.atlasBounds[2] = (float)glyph.width;
+        result.atlasBounds[3] = (float)glyph.height;
+    }
 
-        msdfgen::destroyFont(font);
-        msdfgen::deinitializeFreetype(ft);
+    /**
+     * The single-glyph pipeline: outline (cached), frame, then rasterization of N channels
+     * (1 = SDF, 3 = MSDF, 4 = MTSDF) into result.pixels as float samples, with variation axes
+     * (numAxes = 0 for defaults). Precision and sparse options apply as on every other path.
+     */
+    template <int N>
+    inline GlyphResult generateGlyph(FontSession& session, uint32_t charCode, double fontSize, double pixelRange,
+                                     const VariationAxis* axes, int numAxes,
+                                     const RasterOptions& options = RasterOptions()) {
+        GlyphResult result;
+        result.success = false;
+        result.channels = N;
+
+        setSessionAxes(session, axes, numAxes);
+        GlyphGeometry glyph;
+        if (!prepareGlyph(session, charCode, fontSize, pixelRange, glyph)) return result;
+
+        fillMetrics(result, glyph, N);
+        result.pixels.resize((size_t)glyph.width * glyph.height * N);
+        PixelTarget target;
+        target.data = result.pixels.data();
+        target.width = glyph.width;
+        target.height = glyph.height;
+        target.rowStride = 0;
+        target.format = FORMAT_FLOAT32;
+        renderInto(target, N, glyph, pixelRange, options);
         return result;
     }
+
+    // Single MSDF glyph (3 channels) of the default instance
+    inline GlyphResult generateOne(FontSession& session, uint32_t charCode, double fontSize, double pixelRange) {
+        return generateGlyph<3>(session, charCode, fontSize, pixelRange, nullptr, 0);
+    }
+
+    // Single MTSDF glyph (4 channels) of the default instance
+    inline GlyphResult generateOneMTSDF(FontSession& session, uint32_t charCode, double fontSize, double pixelRange) {
+        return generateGlyph<4>(session, charCode, fontSize, pixelRange, nullptr, 0);
+    }
+
+    // Single MSDF glyph (3 channels) with variation axes
+    inline GlyphResult generateOneVar(FontSession& session, uint32_t charCode,
+                                       double fontSize, double pixelRange,
+                                       const VariationAxis* axes, int numAxes) {
+        return generateGlyph<3>(session, charCode, fontSize, pixelRange, axes, numAxes);
+    }
+
+    // Single MTSDF glyph (4 channels) with variation axes
+    inline GlyphResult generateOneMTSDFVar(FontSession& session, uint32_t charCode,
+                                            double fontSize, double pixelRange,
+                                            const VariationAxis* axes, int numAxes) {
+        return generateGlyph<4>(session, charCode, fontSize, pixelRange, axes, numAxes);
+    }
+
+    /**
+     * Generate a glyph of the given mode with variation axes (numAxes = 0 for defaults).
+     */
+    inline GlyphResult generateMode(FontSession& session, int mode, uint32_t charCode,
+                                    double fontSize, double pixelRange,
+                                    const VariationAxis* axes, int numAxes,
+                                    const RasterOptions& options = RasterOptions()) {
+        switch (mode) {
+        case MODE_MTSDF: return generateGlyph<4>(session, charCode, fontSize, pixelRange, axes, numAxes, options);
+        case MODE_SDF: return generateGlyph<1>(session, charCode, fontSize, pixelRange, axes, numAxes, options);
+        default: return generateGlyph<3>(session, charCode, fontSize, pixelRange, axes, numAxes, options);
+        }
+    }
+
+    /**
+     * Generate a glyph straight into a caller-owned region, with variation axes (numAxes = 0 for defaults).
+     * result receives the metrics (result.pixels stays empty). Returns true if pixels were written;
+     * false with result.success = true means the region was smaller than result.width x result.height.
+     */
+    inline bool generateInto(FontSession& session, int mode, uint32_t charCode, double fontSize, double pixelRange,
+                             const VariationAxis* axes, int numAxes, const PixelTarget& target, GlyphResult& result,
+                             const RasterOptions& options = RasterOptions()) {
+        result.success = false;
+        result.channels = modeChannels(mode);
+
+        setSessionAxes(session, axes, numAxes);
+        GlyphGeometry glyph;
+        if (!prepareGlyph(session, charCode, fontSize, pixelRange, glyph)) return false;
+
+        fillMetrics(result, glyph, result.channels);
+        return renderInto(target, result.channels, glyph, pixelRange, options);
+    }
 }
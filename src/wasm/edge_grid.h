@@ -0,0 +1,220 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include "msdfgen.h"
+
+// Contour culling for complex outlines: each tile of the bitmap only sees the contours that can reach it.
+// Also home of the per-channel-count msdfgen dispatch shared by every raster path.
+
+namespace msdf_core {
+
+    // Single channel: a plain signed distance field (error correction does not apply)
+    inline void generateSection(const msdfgen::BitmapSection<float, 1>& section, const msdfgen::Shape& shape,
+                                const msdfgen::Projection& projection, double range,
+                                const msdfgen::MSDFGeneratorConfig& config) {
+        msdfgen::generateSDF(section, shape, projection, range, config);
+    }
+
+    inline void generateSection(const msdfgen::BitmapSection<float, 3>& section, const msdfgen::Shape& shape,
+                                const msdfgen::Projection& projection, double range,
+                                const msdfgen::MSDFGeneratorConfig& config) {
+        msdfgen::generateMSDF(section, shape, projection, range, config);
+    }
+
+    inline void generateSection(const msdfgen::BitmapSection<float, 4>& section, const msdfgen::Shape& shape,
+                                const msdfgen::Projection& projection, double range,
+                                const msdfgen::MSDFGeneratorConfig& config) {
+        msdfgen::generateMTSDF(section, shape, projection, range, config);
+    }
+
+    // msdfErrorCorrection per channel count; a single channel has no corners to correct
+    inline void correctErrors(const msdfgen::BitmapSection<float, 1>&, const msdfgen::Shape&,
+                              const msdfgen::SDFTransformation&, const msdfgen::MSDFGeneratorConfig&) {}
+
+    inline void correctErrors(const msdfgen::BitmapSection<float, 3>& section, const msdfgen::Shape& shape,
+                              const msdfgen::SDFTransformation& transformation,
+                              const msdfgen::MSDFGeneratorConfig& config) {
+        msdfgen::msdfErrorCorrection(section, shape, transformation, config);
+    }
+
+    inline void correctErrors(const msdfgen::BitmapSection<float, 4>& section, const msdfgen::Shape& shape,
+                              const msdfgen::SDFTransformation& transformation,
+                              const msdfgen::MSDFGeneratorConfig& config) {
+        msdfgen::msdfErrorCorrection(section, shape, transformation, config);
+    }
+
+    // Tile edge in pixels for culled generation
+    static const int GRID_TILE = 16;
+
+    // Outlines with fewer contours gain nothing from culling (one contour is always kept)
+    static const size_t GRID_MIN_CONTOURS = 3;
+
+    struct EdgeBounds {
+        double l, b, r, t;      // Edge bounding box (font units)
+        double x0, y0;          // Start point: an upper bound of the distance to the edge
+        int color;              // msdfgen::EdgeColor channel bits
+    };
+
+    struct ContourBounds {
+        double l, b, r, t;
+        size_t firstEdge;       // Into EdgeIndex::edges
+        size_t edgeCount;
+    };
+
+    /**
+     * Bounding boxes of an outline's contours and edges, built once per outline after edge
+     * coloring and kept with it in the shape cache. Empty for outlines too simple to cull.
+     */
+    struct EdgeIndex {
+        std::vector<ContourBounds> contours;
+        std::vector<EdgeBounds> edges;
+
+        bool usable() const {
+            return !contours.empty();
+        }
+    };
+
+    inline void buildEdgeIndex(const msdfgen::Shape& shape, EdgeIndex& index) {
+        index.contours.clear();
+        index.edges.clear();
+        if (shape.contours.size() < GRID_MIN_CONTOURS) return;
+        for (const msdfgen::Contour& contour : shape.contours) {
+            ContourBounds bounds;
+            bounds.l = bounds.b = 1e240;
+            bounds.r = bounds.t = -1e240;
+            bounds.firstEdge = index.edges.size();
+            bounds.edgeCount = contour.edges.size();
+            for (const msdfgen::EdgeHolder& edge : contour.edges) {
+                EdgeBounds e;
+                e.l = e.b = 1e240;
+                e.r = e.t = -1e240;
+                edge->bound(e.l, e.b, e.r, e.t);
+                msdfgen::Point2 start = edge->point(0);
+                e.x0 = start.x;
+                e.y0 = start.y;
+                e.color = (int)edge->color;
+                index.edges.push_back(e);
+                if (e.l < bounds.l) bounds.l = e.l;
+                if (e.b < bounds.b) bounds.b = e.b;
+                if (e.r > bounds.r) bounds.r = e.r;
+                if (e.t > bounds.t) bounds.t = e.t;
+            }
+            index.contours.push_back(bounds);
+        }
+    }
+
+    /**
+     * Generates a glyph tile by tile, each tile from a sub-shape of only the contours that
+     * can hold a pixel's nearest edge (per channel) or contain the tile. Such a contour has
+     * an edge whose box is within the nearest distance bound of some channel, or a box that
+     * overlaps the tile.
+     *
+     * Contours are kept whole, so windings and corner neighbours (and with them overlap
+     * support) behave as on the full shape. The one difference: a culled contour's edge
+     * extensions cannot lend a pixel a pseudo-distance, which only shows as msdfgen artifacts
+     * the final error correction would fix.
+     *
+     * Tiles are rendered without error correction; it then runs once over the whole section
+     * against the full shape, when the config asks for it, just as generateSection would.
+     */
+    class ContourCuller {
+    public:
+        ContourCuller(const msdfgen::Shape& shape, const EdgeIndex& index) : work(shape), index(index) {
+            tile.inverseYAxis = shape.inverseYAxis;
+            keep.resize(index.contours.size());
+        }
+
+        /**
+         * Render a section like generateSection with the projection (scale, translate),
+         * culling per GRID_TILE x GRID_TILE block.
+         * @param range Distance range (shape units)
+         */
+        template <int N>
+        void generate(const msdfgen::BitmapSection<float, N>& output, double scale, const msdfgen::Vector2& translate,
+                      double range, const msdfgen::MSDFGeneratorConfig& config) {
+            msdfgen::MSDFGeneratorConfig tileConfig(
+                config.overlapSupport, msdfgen::ErrorCorrectionConfig(msdfgen::ErrorCorrectionConfig::DISABLED));
+            msdfgen::Vector2 scaling(scale, scale);
+            for (int y0 = 0; y0 < output.height; y0 += GRID_TILE) {
+                int y1 = y0 + GRID_TILE < output.height ? y0 + GRID_TILE : output.height;
+                for (int x0 = 0; x0 < output.width; x0 += GRID_TILE) {
+                    int x1 = x0 + GRID_TILE < output.width ? x0 + GRID_TILE : output.width;
+                    // Pixel centers of the tile in shape units
+                    double l = (x0 + 0.5) / scale - translate.x, r = (x1 - 0.5) / scale - translate.x;
+                    double b = (y0 + 0.5) / scale - translate.y, t = (y1 - 0.5) / scale - translate.y;
+                    lend(l, b, r, t, N == 1);
+                    msdfgen::Vector2 offset(translate.x - x0 / scale, translate.y - y0 / scale);
+                    generateSection(output.getSection(x0, y0, x1, y1), tile,
+                                    msdfgen::Projection(scaling, offset), range, tileConfig);
+                    giveBack();
+                }
+            }
+            if (config.errorCorrection.mode != msdfgen::ErrorCorrectionConfig::DISABLED) {
+                correctErrors(output, work,
+                              msdfgen::SDFTransformation(msdfgen::Projection(scaling, translate),
+                                                         msdfgen::DistanceMapping(msdfgen::Range(range))),
+                              config);
+            }
+        }
+
+    private:
+        msdfgen::Shape work;            // Private copy whose contours are moved in and out of tile
+        msdfgen::Shape tile;
+        const EdgeIndex& index;
+        std::vector<char> keep;
+
+        // Largest distance from the rectangle to the point
+        static double farthest(double l, double b, double r, double t, double x, double y) {
+            double dx = fabs(x - l) > fabs(x - r) ? x - l : x - r;
+            double dy = fabs(y - b) > fabs(y - t) ? y - b : y - t;
+            return sqrt(dx * dx + dy * dy);
+        }
+
+        // Smallest distance between two rectangles (0 if they overlap)
+        static double nearest(double l, double b, double r, double t, double bl, double bb, double br, double bt) {
+            double dx = bl > r ? bl - r : (l > br ? l - br : 0);
+            double dy = bb > t ? bb - t : (b > bt ? b - bt : 0);
+            return sqrt(dx * dx + dy * dy);
+        }
+
+        // Move the contours that matter for the rectangle into tile
+        void lend(double l, double b, double r, double t, bool trueDistanceOnly) {
+            // Per channel (red, green, blue) and overall: no pixel is farther from its nearest edge
+            double bound[4] = { 1e240, 1e240, 1e240, 1e240 };
+            for (const EdgeBounds& e : index.edges) {
+                double d = farthest(l, b, r, t, e.x0, e.y0);
+                for (int c = 0; c < 3; ++c) {
+                    if ((e.color & (1 << c)) && d < bound[c]) bound[c] = d;
+                }
+                if (d < bound[3]) bound[3] = d;
+            }
+
+            tile.contours.clear();
+            for (size_t i = 0; i < index.contours.size(); ++i) {
+                const ContourBounds& contour = index.contours[i];
+                bool needed = nearest(l, b, r, t, contour.l, contour.b, contour.r, contour.t) == 0;
+                for (size_t k = 0; !needed && k < contour.edgeCount; ++k) {
+                    const EdgeBounds& e = index.edges[contour.firstEdge + k];
+                    double reach = bound[3];
+                    if (!trueDistanceOnly) {
+                        for (int c = 0; c < 3; ++c) {
+                            if ((e.color & (1 << c)) && bound[c] > reach) reach = bound[c];
+                        }
+                    }
+                    needed = nearest(l, b, r, t, e.l, e.b, e.r, e.t) <= reach;
+                }
+                keep[i] = needed;
+                if (needed) tile.contours.push_back(std::move(work.contours[i]));
+            }
+        }
+
+        void giveBack() {
+            size_t k = 0;
+            for (size_t i = 0; i < keep.size(); ++i) {
+                if (keep[i]) work.contours[i] = std::move(tile.contours[k++]);
+            }
+            tile.contours.clear();
+        }
+    };
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <list>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <unordered_map>
+#include "core.h"
+
+// LRU cache of finished glyphs (metrics + output samples), so repeated requests are a hash probe.
+
+namespace msdf_core {
+
+    /**
+     * Everything that changes a generated glyph.
+     * axes holds the raw VariationAxis records of the request (empty for font defaults).
+     */
+    struct GlyphCacheKey {
+        int fontId;
+        uint32_t codepoint;
+        int mode;
+        int format;
+        double fontSize;
+        double pixelRange;
+        int raster;             // RasterOptions::key()
+        int layout;             // OutputLayout::key()
+        std::string axes;
+
+        bool operator==(const GlyphCacheKey& other) const {
+            return fontId == other.fontId && codepoint == other.codepoint &&
+                   mode == other.mode && format == other.format &&
+                   fontSize == other.fontSize && pixelRange == other.pixelRange &&
+                   raster == other.raster && layout == other.layout && axes == other.axes;
+        }
+    };
+
+    struct GlyphCacheKeyHash {
+        size_t operator()(const GlyphCacheKey& key) const {
+            size_t h = std::hash<std::string>()(key.axes);
+            auto mix = [&h](size_t v) { h ^= v + 0x9e3779b9u + (h << 6) + (h >> 2); };
+            mix((size_t)key.fontId);
+            mix((size_t)key.codepoint);
+            mix((size_t)((key.mode * 2 + key.format) * 64 + key.raster));
+            mix((size_t)key.layout);
+            mix(std::hash<double>()(key.fontSize));
+            mix(std::hash<double>()(key.pixelRange));
+            return h;
+        }
+    };
+
+    inline GlyphCacheKey makeCacheKey(int fontId, uint32_t codepoint, int mode, int format,
+                                      double fontSize, double pixelRange, const RasterOptions& raster,
+                                      const OutputLayout& layout, const VariationAxis* axes, int numAxes) {
+        GlyphCacheKey key;
+        key.fontId = fontId;
+        key.codepoint = codepoint;
+        key.mode = mode;
+        key.format = format;
+        key.fontSize = fontSize;
+        key.pixelRange = pixelRange;
+        key.raster = raster.key();
+        key.layout = layout.key();
+        key.axes = axesKey(axes, numAxes);
+        return key;
+    }
+
+    struct GlyphCacheStats {
+        uint32_t hits;
+        uint32_t misses;
+        uint32_t evictions;
+        uint32_t entries;
+        size_t bytes;           // Pixel bytes currently held
+        size_t budget;          // 0 = cache disabled
+    };
+
+    struct GlyphCacheEntry {
+        GlyphCacheKey key;
+        GlyphResult result;            // Metrics only (result.pixels stays empty)
+        std::vector<uint8_t> pixels;   // Output samples as stored in the scratch buffer (float or uint8 per key.format)
+    };
+
+    /**
+     * Byte-budgeted LRU glyph cache.
+     * Only the pixel payload counts against the budget. Not thread-safe: use it from
+     * the calling thread, before and after parallel work.
+     */
+    class GlyphCache {
+    public:
+        explicit GlyphCache(size_t budget) : budget(budget) {}
+
+        size_t getBudget() const { return budget; }
+
+        void setBudget(size_t bytes) {
+            budget = bytes;
+            evictToBudget();
+        }
+
+        /**
+         * Look up a glyph and mark it most recently used.
+         * Returns nullptr on a miss. The pointer is valid until the next insert or erase.
+         */
+        const GlyphCacheEntry* find(const GlyphCacheKey& key) {
+            if (budget == 0) return nullptr;
+            auto it = index.find(key);
+            if (it == index.end()) {
+                misses++;
+                return nullptr;
+            }
+            hits++;
+            entries.splice(entries.begin(), entries, it->second);
+            return &*it->second;
+        }
+
+        /**
+         * Store a glyph (result.pixels is ignored; pixels are the output samples as bytes).
+         * Glyphs larger than the whole budget are not cached.
+         */
+        void insert(const GlyphCacheKey& key, const GlyphResult& result, const uint8_t* pixels, size_t byteCount) {
+            if (byteCount > budget) return;
+            auto it = index.find(key);
+            if (it != index.end()) remove(it->second);
+
+            entries.emplace_front();
+            GlyphCacheEntry& entry = entries.front();
+            entry.key = key;
+            entry.result = result;
+            entry.result.pixels.clear();
+            entry.pixels.assign(pixels, pixels + byteCount);
+            index[key] = entries.begin();
+            bytes += byteCount;
+            evictToBudget();
+        }
+
+        // Drop every glyph of a font (called when the font id is closed and may be reused)
+        void eraseFont(int fontId) {
+            for (auto it = entries.begin(); it != entries.end();) {
+                auto next = std::next(it);
+                if (it->key.fontId == fontId) remove(it);
+                it = next;
+            }
+        }
+
+        void clear() {
+            entries.clear();
+            index.clear();
+            bytes = 0;
+        }
+
+        void resetStats() {
+            hits = misses = evictions = 0;
+        }
+
+        GlyphCacheStats stats() const {
+            GlyphCacheStats out;
+            out.hits = hits;
+            out.misses = misses;
+            out.evictions = evictions;
+            out.entries = (uint32_t)entries.size();
+            out.bytes = bytes;
+            out.budget = budget;
+            return out;
+        }
+
+    private:
+        std::list<GlyphCacheEntry> entries; // Most recently used first
+        std::unordered_map<GlyphCacheKey, std::list<GlyphCacheEntry>::iterator, GlyphCacheKeyHash> index;
+        size_t budget;
+        size_t bytes = 0;
+        uint32_t hits = 0;
+        uint32_t misses = 0;
+        uint32_t evictions = 0;
+
+        void remove(std::list<GlyphCacheEntry>::iterator it) {
+            bytes -= it->pixels.size();
+            index.erase(it->key);
+            entries.erase(it);
+        }
+
+        void evictToBudget() {
+            while (bytes > budget && !entries.empty()) {
+                remove(std::prev(entries.end()));
+                evictions++;
+            }
+        }
+    };
+}
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+// Pair kerning from the GPOS table: x advance adjustments of the 'kern' feature's pair positioning lookups.
+
+namespace msdf_core {
+
+    /**
+     * Read-only view of the kerning lookups in a font's GPOS table, resolved once.
+     * Takes the lookups of every 'kern' feature, whatever the script or language system
+     * (kerning of one pair hardly differs between them), and reads pair positioning
+     * subtables of both formats, directly or through extension lookups. Values are the
+     * default instance's: variation device tables are not applied. All reads are bounds
+     * checked, so a damaged table yields no kerning rather than a crash.
+     */
+    class PairKerning {
+    public:
+        // gpos: the font's GPOS table, as is (empty if the font has none)
+        explicit PairKerning(std::vector<uint8_t>&& gpos) : table(std::move(gpos)) {
+            collectSubtables();
+        }
+
+        // No kerning lookups (fonts with only a legacy 'kern' table, or none)
+        bool empty() const { return subtables.empty(); }
+
+        // Whether any pair starting with this glyph can be kerned (lets table scans skip rows)
+        bool coversFirst(unsigned glyph) const {
+            for (const Subtable& subtable : subtables) {
+                if (coverageIndex(subtable.coverage, glyph) >= 0) return true;
+            }
+            return false;
+        }
+
+        // Kerning of a glyph pair in font units: the sum over lookups of the first glyph's x advance adjustment
+        int kerning(unsigned first, unsigned second) const {
+            int total = 0;
+            size_t i = 0;
+            while (i < subtables.size()) {
+                int lookup = subtables[i].lookup;
+                // Within one lookup, the first subtable that applies to the pair wins
+                for (; i < subtables.size() && subtables[i].lookup == lookup; ++i) {
+                    int value;
+                    if (pairValue(subtables[i], first, second, value)) {
+                        total += value;
+                        break;
+                    }
+                }
+                while (i < subtables.size() && subtables[i].lookup == lookup) ++i;
+            }
+            return total;
+        }
+
+    private:
+        // A pair positioning subtable; offsets are from the start of the table
+        struct Subtable {
+            int lookup;                 // Lookup list index
+            uint32_t offset;            // Subtable start
+            uint32_t coverage;          // First glyph coverage
+            uint16_t format;            // 1 = glyph pairs, 2 = class pairs
+            uint16_t valueFormat1;      // Value records of the first / second glyph
+            uint16_t valueFormat2;
+        };
+
+        std::vector<uint8_t> table;
+        std::vector<Subtable> subtables; // Grouped by lookup, in lookup order
+
+        // Big-endian reads; 0 past the end of the table
+        uint16_t u16(uint32_t at) const {
+            return (size_t)at + 2 <= table.size() ? (uint16_t)(table[at] << 8 | table[at + 1]) : 0;
+        }
+
+        uint32_t u32(uint32_t at) const {
+            return (uint32_t)u16(at) << 16 | u16(at + 2);
+        }
+
+        // Value record size: 2 bytes per field present
+        static uint32_t valueSize(uint16_t format) {
+            uint32_t size = 0;
+            for (int bit = 0; bit < 8; ++bit) {
+                if (format & (1 << bit)) size += 2;
+            }
+            return size;
+        }
+
+        // XAdvance field of a value record (0 if absent); only XPlacement and YPlacement come before it
+        int16_t xAdvance(uint32_t record, uint16_t format) const {
+            if (!(format & 0x4)) return 0;
+            return (int16_t)u16(record + ((format & 0x1) ? 2 : 0) + ((format & 0x2) ? 2 : 0));
+        }
+
+        void collectSubtables() {
+            if (table.size() < 10 || u16(0) != 1) return;
+            uint32_t featureList = u16(6);
+            uint32_t lookupList = u16(8);
+
+            std::vector<uint16_t> lookups;
+            uint16_t featureCount = u16(featureList);
+            for (uint32_t i = 0; i < featureCount; ++i) {
+                uint32_t record = featureList + 2 + i * 6;
+                if (u32(record) != 0x6b65726e) continue; // 'kern'
+                uint32_t feature = featureList + u16(record + 4);
+                uint16_t lookupCount = u16(feature + 2);
+                for (uint32_t j = 0; j < lookupCount; ++j) lookups.push_back(u16(feature + 4 + j * 2));
+            }
+            // Lookups apply in lookup list order, each once
+            std::sort(lookups.begin(), lookups.end());
+            lookups.erase(std::unique(lookups.begin(), lookups.end()), lookups.end());
+
+            uint16_t lookupCount = u16(lookupList);
+            for (uint16_t index : lookups) {
+                if (index >= lookupCount) continue;
+                uint32_t lookup = lookupList + u16(lookupList + 2 + index * 2);
+                uint16_t type = u16(lookup);
+                uint16_t subtableCount = u16(lookup + 4);
+                for (uint32_t j = 0; j < subtableCount; ++j) {
+                    uint32_t offset = lookup + u16(lookup + 6 + j * 2);
+                    uint16_t subtableType = type;
+                    if (type == 9 && u16(offset) == 1) { // Extension: 32-bit offset to the real subtable
+                        subtableType = u16(offset + 2);
+                        offset += u32(offset + 4);
+                    }
+                    uint16_t format = u16(offset);
+                    if (subtableType != 2 || (format != 1 && format != 2)) continue;
+
+                    Subtable subtable;
+                    subtable.lookup = index;
+                    subtable.offset = offset;
+                    subtable.coverage = offset + u16(offset + 2);
+                    subtable.format = format;
+                    subtable.valueFormat1 = u16(offset + 4);
+                    subtable.valueFormat2 = u16(offset + 6);
+                    subtables.push_back(subtable);
+                }
+            }
+        }
+
+        // Coverage index of a glyph, -1 if not covered
+        int coverageIndex(uint32_t coverage, unsigned glyph) const {
+            uint16_t format = u16(coverage);
+            int count = u16(coverage + 2);
+            int lo = 0, hi = count - 1;
+            if (format == 1) {  // Sorted glyph array
+                while (lo <= hi) {
+                    int mid = (lo + hi) / 2;
+                    unsigned id = u16(coverage + 4 + mid * 2);
+                    if (id == glyph) return mid;
+                    if (id < glyph) lo = mid + 1; else hi = mid - 1;
+                }
+            } else if (format == 2) { // Sorted ranges: start, end, coverage index of start
+                while (lo <= hi) {
+                    int mid = (lo + hi) / 2;
+                    uint32_t range = coverage + 4 + mid * 6;
+                    if (glyph < u16(range)) hi = mid - 1;
+                    else if (glyph > u16(range + 2)) lo = mid + 1;
+                    else return u16(range + 4) + (int)(glyph - u16(range));
+                }
+            }
+            return -1;
+        }
+
+        // Class of a glyph in a class definition table (0 if unlisted)
+        int glyphClass(uint32_t classDef, unsigned glyph) const {
+            uint16_t format = u16(classDef);
+            if (format == 1) {  // Classes of a run of glyphs
+                unsigned start = u16(classDef + 2);
+                unsigned count = u16(classDef + 4);
+                return glyph >= start && glyph < start + count ? u16(classDef + 6 + (glyph - start) * 2) : 0;
+            }
+            if (format == 2) {  // Sorted ranges: start, end, class
+                int lo = 0, hi = (int)u16(classDef + 2) - 1;
+                while (lo <= hi) {
+                    int mid = (lo + hi) / 2;
+                    uint32_t range = classDef + 4 + mid * 6;
+                    if (glyph < u16(range)) hi = mid - 1;
+                    else if (glyph > u16(range + 2)) lo = mid + 1;
+                    else return u16(range + 4);
+                }
+            }
+            return 0;
+        }
+
+        // Adjustment of one subtable; false if it does not apply to the pair
+        bool pairValue(const Subtable& subtable, unsigned first, unsigned second, int& value) const {
+            int index = coverageIndex(subtable.coverage, first);
+            if (index < 0) return false;
+            uint32_t valuesSize = valueSize(subtable.valueFormat1) + valueSize(subtable.valueFormat2);
+
+            if (subtable.format == 1) { // Pair sets per first glyph, sorted by second glyph
+                if (index >= u16(subtable.offset + 8)) return false;
+                uint32_t pairSet = subtable.offset + u16(subtable.offset + 10 + index * 2);
+                uint32_t recordSize = 2 + valuesSize;
+                int lo = 0, hi = (int)u16(pairSet) - 1;
+                while (lo <= hi) {
+                    int mid = (lo + hi) / 2;
+                    uint32_t record = pairSet + 2 + mid * recordSize;
+                    unsigned id = u16(record);
+                    if (id == second) {
+                        value = xAdvance(record + 2, subtable.valueFormat1);
+                        return true;
+                    }
+                    if (id < second) lo = mid + 1; else hi = mid - 1;
+                }
+                return false;
+            }
+
+            // Class pairs: a class1Count x class2Count matrix of value record pairs
+            uint32_t classDef1 = subtable.offset + u16(subtable.offset + 8);
+            uint32_t classDef2 = subtable.offset + u16(subtable.offset + 10);
+            int class1Count = u16(subtable.offset + 12);
+            int class2Count = u16(subtable.offset + 14);
+            int class1 = glyphClass(classDef1, first);
+            int class2 = glyphClass(classDef2, second);
+            if (class1 >= class1Count || class2 >= class2Count) return false;
+            uint32_t record = subtable.offset + 16 + (uint32_t)(class1 * class2Count + class2) * valuesSize;
+            value = xAdvance(record, subtable.valueFormat1);
+            return true;
+        }
+    };
+}
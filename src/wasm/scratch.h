@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "msdfgen.h"
+
+// Per-thread scratch storage for glyph temporaries: grown to the largest glyph seen, then reused.
+
+namespace msdf_core {
+
+    /**
+     * Buffers a glyph needs only while it is rendered: the float bitmap behind quantized
+     * output, the error correction stencil and the sparse band map. Each one grows to its
+     * high-water mark and is never shrunk, so a long run stops allocating after its largest
+     * glyph. Contents are undefined on return; every user overwrites what it asks for.
+     */
+    class GlyphScratch {
+    public:
+        // Float samples for one glyph bitmap (width * height * channels)
+        float* samples(size_t count) {
+            return grow(floats, count);
+        }
+
+        // One byte per pixel, the size msdfgen's error correction expects as its buffer
+        msdfgen::byte* stencil(size_t pixels) {
+            return grow(stencilBytes, pixels);
+        }
+
+        // One flag per tile for renderSparse
+        unsigned char* tiles(size_t count) {
+            return grow(tileFlags, count);
+        }
+
+        // Bytes the buffers grew by since the last call (the per-glyph allocBytes stat)
+        size_t takeGrowth() {
+            size_t bytes = grown;
+            grown = 0;
+            return bytes;
+        }
+
+        // Give the memory back (e.g., from free_buffers)
+        void release() {
+            std::vector<float>().swap(floats);
+            std::vector<msdfgen::byte>().swap(stencilBytes);
+            std::vector<unsigned char>().swap(tileFlags);
+        }
+
+    private:
+        std::vector<float> floats;
+        std::vector<msdfgen::byte> stencilBytes;
+        std::vector<unsigned char> tileFlags;
+        size_t grown = 0;
+
+        template <typename T>
+        T* grow(std::vector<T>& buffer, size_t count) {
+            if (buffer.size() < count) {
+                grown += (count - buffer.size()) * sizeof(T);
+                buffer.resize(count);
+            }
+            return buffer.data();
+        }
+    };
+
+    // Scratch of the calling thread (the main thread, or a pool worker in threaded builds)
+    inline GlyphScratch& glyphScratch() {
+        static thread_local GlyphScratch scratch;
+        return scratch;
+    }
+}
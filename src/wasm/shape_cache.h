@@ -0,0 +1,111 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "msdfgen.h"
+#include "edge_grid.h"
+
+#ifdef MSDF_THREADS
+#include <mutex>
+#endif
+
+// Outline cache: parsed, normalized and edge-colored shapes, reused across sizes and modes.
+
+namespace msdf_core {
+
+    // A glyph outline in font units, ready for projection and rasterization
+    struct CachedShape {
+        msdfgen::Shape shape;   // Normalized and edge-colored
+        double advance;         // Font units
+        double l, b, r, t;      // Shape bounds (0, 0, 1, 1 for empty glyphs)
+        bool empty;             // No contours (e.g., space)
+        bool mayOverlap;        // Contours may overlap: the fast path keeps overlap support
+        bool hasCorners;        // Edge coloring found a corner (CORRECTION_AUTO corrects only these)
+        EdgeIndex edges;        // Contour / edge boxes for culled generation (empty if too simple)
+    };
+
+    /**
+     * LRU map from (glyph index, variation axes) to outlines of one font.
+     * Shared by a session and its per-thread faces, so it locks in threaded builds.
+     * Entries are handed out as shared_ptr and stay valid after eviction.
+     */
+    class ShapeCache {
+    public:
+        explicit ShapeCache(size_t capacity) : capacity(capacity) {}
+
+        std::shared_ptr<const CachedShape> find(unsigned glyphIndex, const std::string& axes) {
+#ifdef MSDF_THREADS
+            std::lock_guard<std::mutex> lock(mutex);
+#endif
+            auto it = index.find(makeKey(glyphIndex, axes));
+            if (it == index.end()) return nullptr;
+            entries.splice(entries.begin(), entries, it->second);
+            return it->second->second;
+        }
+
+        void insert(unsigned glyphIndex, const std::string& axes, std::shared_ptr<const CachedShape> shape) {
+            if (capacity == 0) return;
+#ifdef MSDF_THREADS
+            std::lock_guard<std::mutex> lock(mutex);
+#endif
+            std::string key = makeKey(glyphIndex, axes);
+            auto it = index.find(key);
+            if (it != index.end()) {
+                it->second->second = std::move(shape);
+                entries.splice(entries.begin(), entries, it->second);
+                return;
+            }
+            entries.emplace_front(key, std::move(shape));
+            index[key] = entries.begin();
+            while (entries.size() > capacity) {
+                index.erase(entries.back().first);
+                entries.pop_back();
+            }
+        }
+
+        // Change the number of outlines kept, evicting the least recently used ones
+        void setCapacity(size_t outlines) {
+#ifdef MSDF_THREADS
+            std::lock_guard<std::mutex> lock(mutex);
+#endif
+            capacity = outlines;
+            while (entries.size() > capacity) {
+                index.erase(entries.back().first);
+                entries.pop_back();
+            }
+        }
+
+        size_t size() {
+#ifdef MSDF_THREADS
+            std::lock_guard<std::mutex> lock(mutex);
+#endif
+            return entries.size();
+        }
+
+        void clear() {
+#ifdef MSDF_THREADS
+            std::lock_guard<std::mutex> lock(mutex);
+#endif
+            entries.clear();
+            index.clear();
+        }
+
+    private:
+        typedef std::pair<std::string, std::shared_ptr<const CachedShape>> Entry;
+
+        size_t capacity;
+        std::list<Entry> entries; // Most recently used first
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+#ifdef MSDF_THREADS
+        std::mutex mutex;
+#endif
+
+        static std::string makeKey(unsigned glyphIndex, const std::string& axes) {
+            std::string key((const char*)&glyphIndex, sizeof(glyphIndex));
+            key += axes;
+            return key;
+        }
+    };
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cmath>
+#include <cstring>
+#include "msdfgen.h"
+#include "edge_grid.h"
+#include "scratch.h"
+
+// Band-limited rasterization: exact distances only near the outline, saturated samples elsewhere.
+
+namespace msdf_core {
+
+    // Tile edge in pixels for the coarse band pass
+    static const int SPARSE_TILE = 8;
+
+    /**
+     * Render an SDF / MSDF / MTSDF like generateSDF / generateMSDF / generateMTSDF, but compute
+     * distances only in tiles within one distance range of an edge bounding box.
+     *
+     * Every other tile is farther than the range from all edges, so all of its samples saturate:
+     * one signed distance probe per run of such tiles decides between 0 (outside) and 1 (inside).
+     * Error correction then runs once over the whole bitmap, as generateMSDF would. The band
+     * is grown by the true distance only: per-channel pseudo-distances along edge extensions
+     * can still be unsaturated outside it, and those samples are filled with 0 / 1 instead.
+     * SDF output matches the dense output up to float32 clamping; MSDF / MTSDF channels can
+     * differ there, and error correction, which sees that far field, can change band samples
+     * near them too. Cost scales with the outline length instead of the area.
+     *
+     * @param range Distance range as passed to msdfgen (shape units)
+     * @param culler When set, band runs are generated through it (see ContourCuller)
+     */
+    template <int N>
+    inline void renderSparse(const msdfgen::BitmapSection<float, N>& output, const msdfgen::Shape& shape,
+                             double scale, const msdfgen::Vector2& translate, double range,
+                             const msdfgen::MSDFGeneratorConfig& config, ContourCuller* culler = nullptr) {
+        int tilesX = (output.width + SPARSE_TILE - 1) / SPARSE_TILE;
+        int tilesY = (output.height + SPARSE_TILE - 1) / SPARSE_TILE;
+        msdfgen::Vector2 scaling(scale, scale);
+
+        // Too small for a tile to lie outside the band
+        if (tilesX < 3 || tilesY < 3) {
+            if (culler) culler->generate(output, scale, translate, range, config);
+            else generateSection(output, shape, msdfgen::Projection(scaling, translate), range, config);
+            return;
+        }
+
+        // Mark tiles touched by an edge bounding box grown by the range (in pixels)
+        unsigned char* band = glyphScratch().tiles((size_t)tilesX * tilesY);
+        std::memset(band, 0, (size_t)tilesX * tilesY);
+        double margin = range * scale;
+        for (const msdfgen::Contour& contour : shape.contours) {
+            for (const msdfgen::EdgeHolder& edge : contour.edges) {
+                double l = 1e240, b = 1e240, r = -1e240, t = -1e240;
+                edge->bound(l, b, r, t);
+                int x0 = (int)floor(((l + translate.x) * scale - margin) / SPARSE_TILE);
+                int y0 = (int)floor(((b + translate.y) * scale - margin) / SPARSE_TILE);
+                int x1 = (int)floor(((r + translate.x) * scale + margin) / SPARSE_TILE);
+                int y1 = (int)floor(((t + translate.y) * scale + margin) / SPARSE_TILE);
+                if (x0 < 0) x0 = 0;
+                if (y0 < 0) y0 = 0;
+                if (x1 >= tilesX) x1 = tilesX - 1;
+                if (y1 >= tilesY) y1 = tilesY - 1;
+                for (int ty = y0; ty <= y1; ++ty) {
+                    for (int tx = x0; tx <= x1; ++tx) band[(size_t)ty * tilesX + tx] = 1;
+                }
+            }
+        }
+
+        // Distances per run of band tiles; error correction is deferred to the whole bitmap
+        msdfgen::MSDFGeneratorConfig tileConfig(
+            config.overlapSupport, msdfgen::ErrorCorrectionConfig(msdfgen::ErrorCorrectionConfig::DISABLED));
+        msdfgen::GeneratorConfig probeConfig(config.overlapSupport);
+
+        for (int ty = 0; ty < tilesY; ++ty) {
+            int py0 = ty * SPARSE_TILE;
+            int py1 = py0 + SPARSE_TILE < output.height ? py0 + SPARSE_TILE : output.height;
+            int tx = 0;
+            while (tx < tilesX) {
+                unsigned char inBand = band[(size_t)ty * tilesX + tx];
+                int runEnd = tx + 1;
+                while (runEnd < tilesX && band[(size_t)ty * tilesX + runEnd] == inBand) runEnd++;
+                int px0 = tx * SPARSE_TILE;
+                int px1 = runEnd * SPARSE_TILE < output.width ? runEnd * SPARSE_TILE : output.width;
+
+                if (inBand) {
+                    msdfgen::Vector2 offset(translate.x - px0 / scale, translate.y - py0 / scale);
+                    if (culler) {
+                        culler->generate(output.getSection(px0, py0, px1, py1), scale, offset, range, tileConfig);
+                    } else {
+                        generateSection(output.getSection(px0, py0, px1, py1), shape,
+                                        msdfgen::Projection(scaling, offset), range, tileConfig);
+                    }
+                } else {
+                    // No edge passes near the run, so one probe gives the side of all of it
+                    float probe = 0;
+                    msdfgen::Vector2 offset(translate.x - px0 / scale, translate.y - py0 / scale);
+                    msdfgen::generateSDF(msdfgen::BitmapSection<float, 1>(&probe, 1, 1), shape,
+                                         msdfgen::Projection(scaling, offset), range, probeConfig);
+                    float fill = probe > 0.5f ? 1.0f : 0.0f;
+                    for (int y = py0; y < py1; ++y) {
+                        float* row = output(px0, y);
+                        for (int i = 0, n = (px1 - px0) * N; i < n; ++i) row[i] = fill;
+                    }
+                }
+                tx = runEnd;
+            }
+        }
+
+        if (config.errorCorrection.mode != msdfgen::ErrorCorrectionConfig::DISABLED) {
+            correctErrors(output, shape,
+                          msdfgen::SDFTransformation(msdfgen::Projection(scaling, translate),
+                                                     msdfgen::DistanceMapping(msdfgen::Range(range))),
+                          config);
+        }
+    }
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#ifdef MSDF_STATS
+#include <chrono>
+#include <vector>
+#include <mutex>
+#endif
+
+// Optional per-glyph instrumentation. Built with MSDF_STATS (make STATS=1), core.h records
+// stage timings, bitmap sizes and allocations of every rendered glyph into a ring buffer;
+// without it the hooks are compiled out.
+
+namespace msdf_core {
+
+    enum GlyphStatsFlags {
+        STATS_SHAPE_CACHED = 1, // Outline came from the shape cache (no load / coloring)
+        STATS_GLYPH_CACHED = 2, // Whole glyph came from the glyph cache (copy only)
+        STATS_UINT8 = 4         // Quantized output
+    };
+
+    // One record per glyph; 10 x 4 bytes, the layout get_stats writes
+    struct GlyphStats {
+        uint32_t codepoint;
+        uint32_t flags;         // GlyphStatsFlags
+        uint32_t width;
+        uint32_t height;
+        uint32_t channels;
+        uint32_t allocBytes;    // Scratch memory the glyph had to grow (0 once warmed up)
+        float loadUs;           // FreeType outline load
+        float coloringUs;       // normalize + edgeColoringSimple
+        float rasterUs;         // generateMSDF / generateMTSDF
+        float packUs;           // Quantization or copy into the output
+    };
+    static_assert(sizeof(GlyphStats) == 40, "get_stats record layout");
+
+    // Running sums since the last reset (not limited by the ring size)
+    struct StatsTotals {
+        uint64_t glyphs;
+        uint64_t shapeCacheHits;
+        uint64_t glyphCacheHits;
+        uint64_t allocBytes;    // Per-glyph temporaries plus scratch buffer growth
+        double loadUs;
+        double coloringUs;
+        double rasterUs;
+        double packUs;
+    };
+
+#ifdef MSDF_STATS
+
+    static const size_t STATS_RING_CAPACITY = 1024;
+
+    class StatsRing {
+    public:
+        StatsRing() : records(STATS_RING_CAPACITY) {
+            reset();
+        }
+
+        void record(const GlyphStats& stats) {
+            std::lock_guard<std::mutex> lock(mutex);
+            records[next] = stats;
+            next = (next + 1) % records.size();
+            if (count < records.size()) count++;
+
+            sums.glyphs++;
+            if (stats.flags & STATS_SHAPE_CACHED) sums.shapeCacheHits++;
+            if (stats.flags & STATS_GLYPH_CACHED) sums.glyphCacheHits++;
+            sums.allocBytes += stats.allocBytes;
+            sums.loadUs += stats.loadUs;
+            sums.coloringUs += stats.coloringUs;
+            sums.rasterUs += stats.rasterUs;
+            sums.packUs += stats.packUs;
+        }
+
+        // Allocations that do not belong to one glyph (e.g., scratch buffer growth)
+        void addAllocBytes(size_t bytes) {
+            std::lock_guard<std::mutex> lock(mutex);
+            sums.allocBytes += bytes;
+        }
+
+        // Copy up to max of the most recent records, oldest first; returns the number copied
+        int copyRecent(GlyphStats* out, int max) {
+            std::lock_guard<std::mutex> lock(mutex);
+            size_t n = count < (size_t)max ? count : (size_t)max;
+            size_t start = (next + records.size() - n) % records.size();
+            for (size_t i = 0; i < n; ++i) {
+                out[i] = records[(start + i) % records.size()];
+            }
+            return (int)n;
+        }
+
+        StatsTotals totals() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return sums;
+        }
+
+        size_t size() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return count;
+        }
+
+        void reset() {
+            std::lock_guard<std::mutex> lock(mutex);
+            next = 0;
+            count = 0;
+            sums = StatsTotals();
+        }
+
+    private:
+        std::vector<GlyphStats> records;
+        size_t next;
+        size_t count;
+        StatsTotals sums;
+        std::mutex mutex;   // Always taken: native tools record from threads of their own, not only the pool's
+    };
+
+    inline StatsRing& statsRing() {
+        static StatsRing ring;
+        return ring;
+    }
+
+    // Stopwatch: lapUs() returns microseconds since construction or the previous lap
+    class StatsTimer {
+    public:
+        StatsTimer() : last(std::chrono::steady_clock::now()) {}
+
+        float lapUs() {
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            float us = std::chrono::duration<float, std::micro>(now - last).count();
+            last = now;
+            return us;
+        }
+
+    private:
+        std::chrono::steady_clock::time_point last;
+    };
+
+#endif
+}
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <vector>
+#include "core.h"
+
+#ifdef MSDF_THREADS
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+#endif
+
+// Parallel glyph generation. Built with MSDF_THREADS (the -pthread WASM target) this
+// spreads glyphs over a work-stealing pool; otherwise everything runs on the calling thread.
+
+namespace msdf_core {
+
+#ifdef MSDF_THREADS
+
+    /**
+     * Fixed-size work-stealing pool.
+     * The calling thread takes part as participant 0, so a pool of size N starts N - 1 threads.
+     * Each participant drains its own queue from the front, then steals from the back of the others.
+     */
+    class WorkStealingPool {
+    public:
+        explicit WorkStealingPool(int size) {
+            if (size < 1) size = 1;
+            for (int i = 0; i < size; ++i) {
+                queues.emplace_back(new Queue());
+            }
+            for (int i = 1; i < size; ++i) {
+                workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+            }
+        }
+
+        ~WorkStealingPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (std::thread& worker : workers) worker.join();
+        }
+
+        int size() const { return (int)queues.size(); }
+
+        /**
+         * Run task(participant, index) for every index in [0, count) and wait for all of them.
+         * Indices start out split into one contiguous block per participant.
+         */
+        void run(int count, const std::function<void(int, int)>& fn) {
+            int n = size();
+            int block = (count + n - 1) / n;
+            for (int t = 0; t < n; ++t) {
+                std::lock_guard<std::mutex> lock(queues[t]->mutex);
+                for (int i = t * block; i < count && i < (t + 1) * block; ++i) {
+                    queues[t]->items.push_back(i);
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                task = &fn;
+                active = (int)workers.size();
+                generation++;
+            }
+            wake.notify_all();
+
+            drain(0);
+
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [this] { return active == 0; });
+            task = nullptr;
+        }
+
+    private:
+        struct Queue {
+            std::mutex mutex;
+            std::deque<int> items;
+        };
+
+        std::vector<std::unique_ptr<Queue>> queues;
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+        const std::function<void(int, int)>* task = nullptr;
+        unsigned generation = 0;
+        int active = 0;
+        bool stopping = false;
+
+        bool next(int self, int& index) {
+            {
+                Queue& own = *queues[self];
+                std::lock_guard<std::mutex> lock(own.mutex);
+                if (!own.items.empty()) {
+                    index = own.items.front();
+                    own.items.pop_front();
+                    return true;
+                }
+            }
+            for (int i = 1; i < size(); ++i) {
+                Queue& victim = *queues[(self + i) % size()];
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if (!victim.items.empty()) {
+                    index = victim.items.back();
+                    victim.items.pop_back();
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void drain(int self) {
+            int index;
+            while (next(self, index)) {
+                (*task)(self, index);
+            }
+        }
+
+        void workerLoop(int self) {
+            unsigned seen = 0;
+            for (;;) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [&] { return stopping || generation != seen; });
+                    if (stopping) return;
+                    seen = generation;
+                }
+                drain(self);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (--active == 0) done.notify_one();
+                }
+            }
+        }
+    };
+
+    inline std::unique_ptr<WorkStealingPool>& poolInstance() {
+        static std::unique_ptr<WorkStealingPool> pool(new WorkStealingPool(1));
+        return pool;
+    }
+
+    /**
+     * Set the number of threads used for parallel generation (including the calling thread).
+     * In the browser this must not exceed the pre-spawned pthread pool, or thread creation
+     * would block waiting for the main thread.
+     */
+    inline void setThreadCount(int count) {
+        if (count < 1) count = 1;
+        if (count == poolInstance()->size()) return;
+        poolInstance().reset(new WorkStealingPool(count));
+    }
+
+    inline int threadCount() {
+        return poolInstance()->size();
+    }
+
+#else
+
+    inline void setThreadCount(int) {}
+
+    inline int threadCount() {
+        return 1;
+    }
+
+#endif
+
+    /**
+     * Make sure the session has one FreeType face per thread.
+     * FreeType faces are not thread-safe, so participant t > 0 uses threadFaces[t - 1].
+     * All faces share the session's shape cache.
+     * Must be called on the owning thread, before work is handed out.
+     */
+    inline void prepareThreadFaces(FontSession& session, int threads) {
+        while ((int)session.threadFaces.size() < threads - 1) {
+            FontSession* face = openFontView(session.data, session.length);
+            if (!face) break;
+            face->shapes = session.shapes;
+            session.threadFaces.push_back(face);
+        }
+    }
+
+    inline FontSession& threadFace(FontSession& session, int participant) {
+        if (participant == 0 || participant > (int)session.threadFaces.size()) return session;
+        return *session.threadFaces[participant - 1];
+    }
+
+    /**
+     * Call fn(face, index) for every index in [0, count), in parallel when threads are available.
+     * face is a FontSession private to the running thread (same font, separate FreeType face).
+     */
+    template <typename Fn>
+    inline void parallelGlyphs(FontSession& session, int count, Fn fn) {
+#ifdef MSDF_THREADS
+        WorkStealingPool& pool = *poolInstance();
+        if (pool.size() > 1 && count > 1) {
+            prepareThreadFaces(session, pool.size());
+            if ((int)session.threadFaces.size() == pool.size() - 1) {
+                pool.run(count, [&](int participant, int index) {
+                    fn(threadFace(session, participant), index);
+                });
+                return;
+            }
+        }
+#endif
+        for (int i = 0; i < count; ++i) {
+            fn(session, i);
+        }
+    }
+}
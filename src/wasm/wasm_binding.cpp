@@ -1,15 +1,201 @@
 #include <emscripten.h>
 #include <vector>
 #include "core.h"
+#include "atlas.h"
+#include "atlas_file.h"
+#include "thread_pool.h"
+#include "glyph_cache.h"
 
 // GLOBAL SCRATCH BUFFERS
 // Reused across calls to avoid malloc/free overhead and fragmentation.
 // 1. Font Data Buffer (Input)
 std::vector<uint8_t> g_fontBuffer;
-// 2. Pixel Data Buffer (Output)
+// 2. Pixel Data Buffers (Output): float samples, or quantized bytes for FORMAT_UINT8
 std::vector<float> g_pixelBuffer;
+std::vector<uint8_t> g_byteBuffer;
 // 3. Variation Axes Buffer (Input)
 std::vector<msdf_core::VariationAxis> g_axesBuffer;
+// 4. Atlas File Buffer (Output of generate_atlas_file)
+std::vector<uint8_t> g_fileBuffer;
+
+// VARIATION INSTANCE QUANTIZATION
+// Axis values are snapped to a step before they are stored, so an animated axis lands on a
+// finite set of instances whose outlines and glyphs stay cached. Per-tag steps override the default.
+double g_axisStepDefault = 0.0;
+std::vector<msdf_core::VariationAxis> g_axisSteps; // tag + step
+
+// OUTLINE CACHE
+// Outlines kept per open font (see shape_cache.h), across all variation instances.
+size_t g_outlineCapacity = msdf_core::SHAPE_CACHE_CAPACITY;
+
+// OPEN FONTS
+// Font id N lives at g_fonts[N - 1]; closed slots are nullptr. Id 0 is never valid.
+std::vector<msdf_core::FontSession*> g_fonts;
+
+// GLYPH CACHE
+// Finished glyphs of generate_glyph* / generate_batch, keyed by font, codepoint, size, range, mode,
+// format and axes. Budget counts pixel bytes only; set_glyph_cache_budget(0) disables it.
+static const size_t GLYPH_CACHE_DEFAULT_BUDGET = 16 * 1024 * 1024;
+msdf_core::GlyphCache g_glyphCache(GLYPH_CACHE_DEFAULT_BUDGET);
+
+// RASTER OPTIONS
+// Precision, error correction, sparse mode and contour culling used by every generate export;
+// part of the glyph cache key.
+msdf_core::RasterOptions g_raster;
+
+// OUTPUT LAYOUT
+// Row order, row alignment and channel padding of generate_glyph* / generate_batch / generate_atlas*
+// output; part of the glyph cache key. Caller-owned targets (generate_glyph_into, atlas streams) keep their own.
+msdf_core::OutputLayout g_layout;
+
+// STREAMING ATLASES
+// Atlas stream N lives at g_atlasStreams[N - 1] (see open_atlas_stream); closed slots are nullptr.
+std::vector<msdf_core::StreamingAtlas*> g_atlasStreams;
+
+static msdf_core::FontSession* getFont(int fontId) {
+    if (fontId <= 0 || fontId > (int)g_fonts.size()) return nullptr;
+    return g_fonts[fontId - 1];
+}
+
+static msdf_core::StreamingAtlas* getAtlasStream(int streamId) {
+    if (streamId <= 0 || streamId > (int)g_atlasStreams.size()) return nullptr;
+    return g_atlasStreams[streamId - 1];
+}
+
+// Char table record of generate_atlas / atlas_stream_add
+static const int ATLAS_CHAR_STRIDE = 8;
+
+static void writeAtlasChar(const msdf_core::AtlasGlyph& glyph, float* out) {
+    out[0] = glyph.placed ? 1.0f : 0.0f;
+    out[1] = (float)glyph.x;
+    out[2] = (float)glyph.y;
+    out[3] = (float)glyph.width;
+    out[4] = (float)glyph.height;
+    out[5] = glyph.xoffset;
+    out[6] = glyph.yoffset;
+    out[7] = glyph.xadvance;
+}
+
+static double axisStep(const char* tag) {
+    for (const msdf_core::VariationAxis& step : g_axisSteps) {
+        if (std::strncmp(step.tag, tag, 4) == 0) return step.value;
+    }
+    return g_axisStepDefault;
+}
+
+// Axis record from a tag packed as 4 ASCII bytes (first character in the low byte)
+static msdf_core::VariationAxis makeAxis(uint32_t tag, double value) {
+    msdf_core::VariationAxis axis;
+    std::memcpy(axis.tag, &tag, 4);
+    axis.tag[4] = '\0';
+    axis.value = msdf_core::quantizeAxisValue(value, axisStep(axis.tag));
+    return axis;
+}
+
+// Metrics record layout shared by all generate exports:
+// [success, width, height, advance, planeL, planeB, planeR, planeT, atlasL, atlasB]
+static const int METRICS_STRIDE = 10;
+
+static void writeMetrics(const msdf_core::GlyphResult& res, float* out) {
+    if (!res.success) {
+        out[0] = 0.0f;
+        return;
+    }
+    out[0] = 1.0f;
+    out[1] = (float)res.width;
+    out[2] = (float)res.height;
+    out[3] = res.advance;
+    out[4] = res.planeBounds[0];
+    out[5] = res.planeBounds[1];
+    out[6] = res.planeBounds[2];
+    out[7] = res.planeBounds[3];
+    out[8] = res.atlasBounds[0];
+    out[9] = res.atlasBounds[1];
+}
+
+// Scratch buffer for the format, grown to hold count samples. Returns its start.
+static void* scratchPixels(size_t count, int format) {
+    if (format == msdf_core::FORMAT_UINT8) {
+        if (g_byteBuffer.size() < count) {
+#ifdef MSDF_STATS
+            msdf_core::statsRing().addAllocBytes(count - g_byteBuffer.size());
+#endif
+            g_byteBuffer.resize(count);
+        }
+        return g_byteBuffer.data();
+    }
+    if (g_pixelBuffer.size() < count) {
+#ifdef MSDF_STATS
+        msdf_core::statsRing().addAllocBytes((count - g_pixelBuffer.size()) * sizeof(float));
+#endif
+        g_pixelBuffer.resize(count);
+    }
+    return g_pixelBuffer.data();
+}
+
+static size_t sampleBytes(int format) {
+    return format == msdf_core::FORMAT_UINT8 ? 1 : sizeof(float);
+}
+
+#ifdef MSDF_STATS
+// Stats record for a glyph served from the glyph cache (all time is the copy)
+static void recordCacheHit(const msdf_core::GlyphCacheEntry& entry, float copyUs) {
+    msdf_core::GlyphStats stats = msdf_core::GlyphStats();
+    stats.codepoint = entry.key.codepoint;
+    stats.flags = msdf_core::STATS_GLYPH_CACHED;
+    if (entry.key.format == msdf_core::FORMAT_UINT8) stats.flags |= msdf_core::STATS_UINT8;
+    stats.width = entry.result.width;
+    stats.height = entry.result.height;
+    stats.channels = entry.result.channels;
+    stats.packUs = copyUs;
+    msdf_core::statsRing().record(stats);
+}
+#endif
+
+// Shared body of the single glyph exports: serve from the cache, or rasterize straight into the scratch buffer.
+static void* generateToScratch(int fontId, int mode, uint32_t charCode, double fontSize, double pixelRange,
+                               const msdf_core::VariationAxis* axes, int numAxes, int format, float* outMetrics) {
+    msdf_core::FontSession* session = getFont(fontId);
+    if (!session) {
+        outMetrics[0] = 0.0f;
+        return nullptr;
+    }
+
+    msdf_core::GlyphCacheKey key = msdf_core::makeCacheKey(fontId, charCode, mode, format, fontSize, pixelRange,
+                                                           g_raster, g_layout, axes, numAxes);
+    if (const msdf_core::GlyphCacheEntry* cached = g_glyphCache.find(key)) {
+#ifdef MSDF_STATS
+        msdf_core::StatsTimer timer;
+#endif
+        void* out = scratchPixels(cached->pixels.size() / sampleBytes(format), format);
+        std::memcpy(out, cached->pixels.data(), cached->pixels.size());
+#ifdef MSDF_STATS
+        recordCacheHit(*cached, timer.lapUs());
+#endif
+        writeMetrics(cached->result, outMetrics);
+        return out;
+    }
+
+    msdf_core::setSessionAxes(*session, axes, numAxes);
+    msdf_core::GlyphGeometry glyph;
+    if (!msdf_core::prepareGlyph(*session, charCode, fontSize, pixelRange, glyph)) {
+        outMetrics[0] = 0.0f;
+        return nullptr;
+    }
+
+    int channels = msdf_core::modeChannels(mode);
+    size_t samples = (size_t)g_layout.rowStride(glyph.width, channels, format) * glyph.height;
+    msdf_core::PixelTarget target = g_layout.target(scratchPixels(samples, format), glyph.width, glyph.height,
+                                                    channels, format);
+    if (g_layout.rowAlign > 1) std::memset(target.data, 0, samples * sampleBytes(format)); // Row padding
+    msdf_core::renderInto(target, channels, glyph, pixelRange, g_raster);
+
+    msdf_core::GlyphResult res;
+    msdf_core::fillMetrics(res, glyph, g_layout.storedChannels(channels));
+    writeMetrics(res, outMetrics);
+    g_glyphCache.insert(key, res, (const uint8_t*)target.data, samples * sampleBytes(format));
+    return target.data;
+}
 
 extern "C" {
 
@@ -29,95 +215,62 @@ extern "C" {
     }
 
     /**
-     * Generate a single MSDF glyph (3 channels).
+     * Open a font from the bytes copied into the font buffer.
+     * The font is parsed once and stays loaded until close_font.
+     * The session takes over the buffer, so the next prepare_font_buffer starts fresh.
+     *
+     * @param fontLen Size of the font data in bytes
+     * @return Font id (> 0), or 0 if the data could not be loaded
      */
     EMSCRIPTEN_KEEPALIVE
-    float* generate_glyph(int fontLen, uint32_t charCode, double fontSize, double pixelRange, float* outMetrics) {
-        
-        // 1. Generate using Core logic
-        msdf_core::GlyphResult res = msdf_core::generateOne(
-            g_fontBuffer.data(), 
-            fontLen, 
-            charCode, 
-            fontSize, 
-            pixelRange
-        );
-        
-        if (!res.success) {
-            outMetrics[0] = 0.0f; // Success = false
-            return nullptr;
+    int open_font(int fontLen) {
+        if (fontLen <= 0 || (size_t)fontLen > g_fontBuffer.size()) return 0;
+
+        g_fontBuffer.resize(fontLen);
+        msdf_core::FontSession* session = msdf_core::openFont(std::move(g_fontBuffer));
+        g_fontBuffer = std::vector<uint8_t>();
+        if (!session) return 0;
+        if (g_outlineCapacity != msdf_core::SHAPE_CACHE_CAPACITY) session->shapes->setCapacity(g_outlineCapacity);
+
+        // Reuse a closed slot if there is one
+        for (size_t i = 0; i < g_fonts.size(); ++i) {
+            if (!g_fonts[i]) {
+                g_fonts[i] = session;
+                return (int)i + 1;
+            }
         }
+        g_fonts.push_back(session);
+        return (int)g_fonts.size();
+    }
 
-        // 2. Write Metrics
-        outMetrics[0] = 1.0f; // Success
-        outMetrics[1] = (float)res.width;
-        outMetrics[2] = (float)res.height;
-        outMetrics[3] = res.advance;
-        outMetrics[4] = res.planeBounds[0]; // L
-        outMetrics[5] = res.planeBounds[1]; // B
-        outMetrics[6] = res.planeBounds[2]; // R
-        outMetrics[7] = res.planeBounds[3]; // T
-        outMetrics[8] = res.atlasBounds[0]; // Atlas L (always 0)
-        outMetrics[9] = res.atlasBounds[1]; // Atlas B (always 0)
-        
-        // 3. Resize Output Buffer if needed
-        size_t neededBytes = res.pixels.size() * sizeof(float);
-        size_t neededFloats = res.pixels.size();
-        
-        if (g_pixelBuffer.size() < neededFloats) {
-            g_pixelBuffer.resize(neededFloats);
-        }
-        
-        // 4. Copy Pixels to Output Buffer
-        std::memcpy(g_pixelBuffer.data(), res.pixels.data(), neededBytes);
-        
-        return g_pixelBuffer.data();
+    /**
+     * Close a font opened with open_font. Unknown ids are ignored.
+     */
+    EMSCRIPTEN_KEEPALIVE
+    void close_font(int fontId) {
+        msdf_core::FontSession* session = getFont(fontId);
+        if (!session) return;
+        msdf_core::closeFont(session);
+        g_fonts[fontId - 1] = nullptr;
+        g_glyphCache.eraseFont(fontId);
     }
 
     /**
-     * Generate a single MTSDF glyph (4 channels).
+     * Generate a single MSDF glyph (3 channels).
+     * @param format 0 = float32 samples, 1 = uint8 (quantized in C++)
+     * @return Pointer to the pixel buffer (float* or uint8_t* per format), or nullptr on failure
      */
     EMSCRIPTEN_KEEPALIVE
-    float* generate_mtsdf_glyph(int fontLen, uint32_t charCode, double fontSize, double pixelRange, float* outMetrics) {
-        
-        // 1. Generate using Core logic
-        msdf_core::GlyphResult res = msdf_core::generateOneMTSDF(
-            g_fontBuffer.data(), 
-            fontLen, 
-            charCode, 
-            fontSize, 
-            pixelRange
-        );
-        
-        if (!res.success) {
-            outMetrics[0] = 0.0f; // Success = false
-            return nullptr;
-        }
+    void* generate_glyph(int fontId, uint32_t charCode, double fontSize, double pixelRange, int format, float* outMetrics) {
+        return generateToScratch(fontId, msdf_core::MODE_MSDF, charCode, fontSize, pixelRange, nullptr, 0, format, outMetrics);
+    }
 
-        // 2. Write Metrics
-        outMetrics[0] = 1.0f; // Success
-        outMetrics[1] = (float)res.width;
-        outMetrics[2] = (float)res.height;
-        outMetrics[3] = res.advance;
-        outMetrics[4] = res.planeBounds[0]; // L
-        outMetrics[5] = res.planeBounds[1]; // B
-        outMetrics[6] = res.planeBounds[2]; // R
-        outMetrics[7] = res.planeBounds[3]; // T
-        outMetrics[8] = res.atlasBounds[0]; // Atlas L (always 0)
-        outMetrics[9] = res.atlasBounds[1]; // Atlas B (always 0)
-        
-        // 3. Resize Output Buffer if needed
-        size_t neededBytes = res.pixels.size() * sizeof(float);
-        size_t neededFloats = res.pixels.size();
-        
-        if (g_pixelBuffer.size() < neededFloats) {
-            g_pixelBuffer.resize(neededFloats);
-        }
-        
-        // 4. Copy Pixels to Output Buffer
-        std::memcpy(g_pixelBuffer.data(), res.pixels.data(), neededBytes);
-        
-        return g_pixelBuffer.data();
+    /**
+     * Generate a single MTSDF glyph (4 channels).
+     */
+    EMSCRIPTEN_KEEPALIVE
+    void* generate_mtsdf_glyph(int fontId, uint32_t charCode, double fontSize, double pixelRange, int format, float* outMetrics) {
+        return generateToScratch(fontId, msdf_core::MODE_MTSDF, charCode, fontSize, pixelRange, nullptr, 0, format, outMetrics);
     }
 
     /**
@@ -135,91 +288,573 @@ extern "C" {
      */
     EMSCRIPTEN_KEEPALIVE
     void add_variation_axis(const char* tag, double value) {
-        msdf_core::VariationAxis axis;
-        std::strncpy(axis.tag, tag, 4);
-        axis.tag[4] = '\0';
-        axis.value = value;
-        g_axesBuffer.push_back(axis);
+        uint32_t packed = 0;
+        std::strncpy((char*)&packed, tag, 4);
+        g_axesBuffer.push_back(makeAxis(packed, value));
+    }
+
+    /**
+     * Replace all variation axes in one call (count = 0 for font defaults).
+     * Values are quantized with the steps from set_variation_step.
+     * @param tags count axis tags, each 4 ASCII bytes packed into a uint32 (first character in the low byte)
+     * @param values count axis values
+     */
+    EMSCRIPTEN_KEEPALIVE
+    void set_variation_axes(const uint32_t* tags, const double* values, int count) {
+        g_axesBuffer.clear();
+        for (int i = 0; i < count; ++i) {
+            g_axesBuffer.push_back(makeAxis(tags[i], values[i]));
+        }
+    }
+
+    /**
+     * Quantize axis values to multiples of step when they are set, so nearby values
+     * map to the same variation instance (and hit the same cached outlines and glyphs).
+     * Applies to axes set afterwards.
+     * @param tag Axis tag packed as in set_variation_axes, or 0 for the default of all axes
+     * @param step Step in axis units; 0 keeps values exact
+     */
+    EMSCRIPTEN_KEEPALIVE
+    void set_variation_step(uint32_t tag, double step) {
+        if (tag == 0) {
+            g_axisStepDefault = step;
+            return;
+        }
+        msdf_core::VariationAxis entry;
+        std::memcpy(entry.tag, &tag, 4);
+        entry.tag[4] = '\0';
+        entry.value = step;
+        for (msdf_core::VariationAxis& existing : g_axisSteps) {
+            if (std::strcmp(existing.tag, entry.tag) == 0) {
+                existing.value = step;
+                return;
+            }
+        }
+        g_axisSteps.push_back(entry);
+    }
+
+    /**
+     * Set how many outlines each open font keeps across all variation instances
+     * (default 4096). Evicts least recently used outlines if the cache shrinks.
+     */
+    EMSCRIPTEN_KEEPALIVE
+    void set_outline_cache_capacity(int outlines) {
+        g_outlineCapacity = outlines > 0 ? (size_t)outlines : 0;
+        for (msdf_core::FontSession* session : g_fonts) {
+            if (session) session->shapes->setCapacity(g_outlineCapacity);
+        }
     }
 
     /**
      * Generate MSDF glyph with current variation axes (3 channels).
      */
     EMSCRIPTEN_KEEPALIVE
-    float* generate_glyph_var(int fontLen, uint32_t charCode, double fontSize, double pixelRange, float* outMetrics) {
-        msdf_core::GlyphResult res = msdf_core::generateOneVar(
-            g_fontBuffer.data(),
-            fontLen,
-            charCode,
-            fontSize,
-            pixelRange,
-            g_axesBuffer.data(),
-            (int)g_axesBuffer.size()
-        );
+    void* generate_glyph_var(int fontId, uint32_t charCode, double fontSize, double pixelRange, int format, float* outMetrics) {
+        return generateToScratch(fontId, msdf_core::MODE_MSDF, charCode, fontSize, pixelRange,
+                                 g_axesBuffer.data(), (int)g_axesBuffer.size(), format, outMetrics);
+    }
 
-        if (!res.success) {
-            outMetrics[0] = 0.0f;
+    /**
+     * Generate MTSDF glyph with current variation axes (4 channels).
+     */
+    EMSCRIPTEN_KEEPALIVE
+    void* generate_mtsdf_glyph_var(int fontId, uint32_t charCode, double fontSize, double pixelRange, int format, float* outMetrics) {
+        return generateToScratch(fontId, msdf_core::MODE_MTSDF, charCode, fontSize, pixelRange,
+                                 g_axesBuffer.data(), (int)g_axesBuffer.size(), format, outMetrics);
+    }
+
+    /**
+     * Generate a single glyph of any mode with current variation axes.
+     * The only single glyph export for SDF output.
+     * @param mode 0 = MSDF (3 channels), 1 = MTSDF (4 channels), 2 = SDF (1 channel)
+     */
+    EMSCRIPTEN_KEEPALIVE
+    void* generate_glyph_mode(int fontId, int mode, uint32_t charCode, double fontSize, double pixelRange, int format,
+                              float* outMetrics) {
+        return generateToScratch(fontId, mode, charCode, fontSize, pixelRange,
+                                 g_axesBuffer.data(), (int)g_axesBuffer.size(), format, outMetrics);
+    }
+
+    /**
+     * Generate many glyphs in one call, using the current variation axes.
+     *
+     * Metrics for glyph i are written to outMetrics[i * 10 .. i * 10 + 9] (same layout as
+     * generate_glyph). Pixels of successful glyphs are packed back to back, in input order,
+     * into one arena; failed glyphs take no space. Glyph i starts at the sum of
+     * rowStride * height over the successful glyphs before it (rowStride = width * channels
+     * unless set_output_layout pads rows or channels).
+     *
+     * @param codepoints Array of count Unicode codepoints, or glyph indices with bit 31 set
+     *                   (msdf_core::GLYPH_INDEX_FLAG, e.g. for shaped text)
+     * @param mode 0 = MSDF (3 channels), 1 = MTSDF (4 channels), 2 = SDF (1 channel)
+     * @param format 0 = float32 samples, 1 = uint8 (arena offsets are then in bytes)
+     * @param outMetrics Array of count * 10 floats
+     * @return Pointer to the pixel arena (owned by WASM, reused across calls), or nullptr if the font id is invalid
+     */
+    EMSCRIPTEN_KEEPALIVE
+    void* generate_batch(int fontId, const uint32_t* codepoints, int count, double fontSize, double pixelRange,
+                         int mode, int format, float* outMetrics) {
+        msdf_core::FontSession* session = getFont(fontId);
+        if (!session) {
+            for (int i = 0; i < count; ++i) outMetrics[i * METRICS_STRIDE] = 0.0f;
             return nullptr;
         }
 
-        outMetrics[0] = 1.0f;
-        outMetrics[1] = (float)res.width;
-        outMetrics[2] = (float)res.height;
-        outMetrics[3] = res.advance;
-        outMetrics[4] = res.planeBounds[0];
-        outMetrics[5] = res.planeBounds[1];
-        outMetrics[6] = res.planeBounds[2];
-        outMetrics[7] = res.planeBounds[3];
-        outMetrics[8] = res.atlasBounds[0];
-        outMetrics[9] = res.atlasBounds[1];
+        const msdf_core::VariationAxis* axes = g_axesBuffer.data();
+        int numAxes = (int)g_axesBuffer.size();
+        int channels = msdf_core::modeChannels(mode);
+
+        // 1. Probe the cache; only misses are loaded and measured (in parallel in threaded builds)
+        std::vector<msdf_core::GlyphCacheKey> keys(count);
+        std::vector<const msdf_core::GlyphCacheEntry*> cached(count, nullptr);
+        for (int i = 0; i < count; ++i) {
+            keys[i] = msdf_core::makeCacheKey(fontId, codepoints[i], mode, format, fontSize, pixelRange,
+                                              g_raster, g_layout, axes, numAxes);
+            cached[i] = g_glyphCache.find(keys[i]);
+        }
+
+        std::vector<msdf_core::GlyphGeometry> geometry(count);
+        std::vector<char> loaded(count, 0);
+        msdf_core::parallelGlyphs(*session, count, [&](msdf_core::FontSession& face, int i) {
+            if (cached[i]) return;
+            msdf_core::setSessionAxes(face, axes, numAxes);
+            loaded[i] = msdf_core::prepareGlyph(face, codepoints[i], fontSize, pixelRange, geometry[i]);
+        });
+
+        // 2. Lay out the arena so the pixels can be written in place
+        std::vector<msdf_core::GlyphResult> results(count);
+        std::vector<size_t> offsets(count, 0);
+        size_t total = 0;
+        for (int i = 0; i < count; ++i) {
+            msdf_core::GlyphResult& res = results[i];
+            res.success = false;
+            if (cached[i]) {
+                res = cached[i]->result;
+            } else if (loaded[i]) {
+                msdf_core::fillMetrics(res, geometry[i], g_layout.storedChannels(channels));
+            }
+            if (res.success) {
+                offsets[i] = total;
+                total += (size_t)g_layout.rowStride(res.width, channels, format) * res.height;
+            }
+            writeMetrics(res, outMetrics + i * METRICS_STRIDE);
+        }
+
+        // 3. Copy cache hits and rasterize misses straight into their arena slots
+        uint8_t* arena = (uint8_t*)scratchPixels(total, format);
+        size_t bytesPerSample = sampleBytes(format);
+        if (g_layout.rowAlign > 1) std::memset(arena, 0, total * bytesPerSample); // Row padding
+        for (int i = 0; i < count; ++i) {
+            if (!cached[i]) continue;
+#ifdef MSDF_STATS
+            msdf_core::StatsTimer timer;
+#endif
+            std::memcpy(arena + offsets[i] * bytesPerSample, cached[i]->pixels.data(), cached[i]->pixels.size());
+#ifdef MSDF_STATS
+            recordCacheHit(*cached[i], timer.lapUs());
+#endif
+        }
+        msdf_core::parallelGlyphs(*session, count, [&](msdf_core::FontSession&, int i) {
+            if (!loaded[i]) return;
+            msdf_core::PixelTarget slot = g_layout.target(arena + offsets[i] * bytesPerSample,
+                                                          geometry[i].width, geometry[i].height, channels, format);
+            msdf_core::renderInto(slot, channels, geometry[i], pixelRange, g_raster);
+        });
 
-        size_t neededFloats = res.pixels.size();
-        if (g_pixelBuffer.size() < neededFloats) {
-            g_pixelBuffer.resize(neededFloats);
+        // 4. Remember the new glyphs (after the copies above, since inserting may evict hits)
+        for (int i = 0; i < count; ++i) {
+            if (!loaded[i]) continue;
+            const msdf_core::GlyphResult& res = results[i];
+            g_glyphCache.insert(keys[i], res, arena + offsets[i] * bytesPerSample,
+                                (size_t)g_layout.rowStride(res.width, channels, format) * res.height * bytesPerSample);
         }
-        std::memcpy(g_pixelBuffer.data(), res.pixels.data(), neededFloats * sizeof(float));
 
-        return g_pixelBuffer.data();
+        return arena;
     }
 
     /**
-     * Generate MTSDF glyph with current variation axes (4 channels).
+     * Measure many glyphs without rasterizing them, using the current variation axes:
+     * the metrics generate_batch would write (same frame math, bit for bit), for laying out
+     * text or packing an atlas ahead of rendering. Outlines that are not cached yet are
+     * loaded and bounded only, and not added to the outline cache.
+     *
+     * @param codepoints Array of count Unicode codepoints, or glyph indices with bit 31 set
+     * @param outMetrics Array of count * 10 floats (same layout as generate_glyph)
+     * @return Number of glyphs measured (success = 0 for the others)
      */
     EMSCRIPTEN_KEEPALIVE
-    float* generate_mtsdf_glyph_var(int fontLen, uint32_t charCode, double fontSize, double pixelRange, float* outMetrics) {
-        msdf_core::GlyphResult res = msdf_core::generateOneMTSDFVar(
-            g_fontBuffer.data(),
-            fontLen,
-            charCode,
-            fontSize,
-            pixelRange,
-            g_axesBuffer.data(),
-            (int)g_axesBuffer.size()
-        );
+    int measure_glyphs(int fontId, const uint32_t* codepoints, int count, double fontSize, double pixelRange,
+                       float* outMetrics) {
+        msdf_core::FontSession* session = getFont(fontId);
+        if (!session) {
+            for (int i = 0; i < count; ++i) outMetrics[i * METRICS_STRIDE] = 0.0f;
+            return 0;
+        }
+
+        const msdf_core::VariationAxis* axes = g_axesBuffer.data();
+        int numAxes = (int)g_axesBuffer.size();
+        std::vector<msdf_core::GlyphGeometry> geometry(count);
+        std::vector<char> loaded(count, 0);
+        msdf_core::parallelGlyphs(*session, count, [&](msdf_core::FontSession& face, int i) {
+            msdf_core::setSessionAxes(face, axes, numAxes);
+            loaded[i] = msdf_core::measureGlyph(face, codepoints[i], fontSize, pixelRange, geometry[i]);
+        });
 
-        if (!res.success) {
+        int measured = 0;
+        for (int i = 0; i < count; ++i) {
+            msdf_core::GlyphResult res;
+            res.success = false;
+            if (loaded[i]) {
+                msdf_core::fillMetrics(res, geometry[i], 0); // No pixels, so no channels
+                measured++;
+            }
+            writeMetrics(res, outMetrics + i * METRICS_STRIDE);
+        }
+        return measured;
+    }
+
+    /**
+     * Generate one glyph straight into a caller-owned buffer (e.g., a staging texture
+     * allocated with _malloc), using the current variation axes. Nothing is copied through
+     * the scratch buffers.
+     *
+     * Metrics are written to outMetrics (same layout as generate_glyph) whenever the glyph loads,
+     * so a caller can read the required size back after a 0 return.
+     *
+     * @param mode 0 = MSDF (3 channels), 1 = MTSDF (4 channels), 2 = SDF (1 channel)
+     * @param format 0 = float32 samples, 1 = uint8
+     * @param dest First sample of the destination region (row 0 receives the bottom row of the glyph)
+     * @param destWidth Region width available in pixels
+     * @param destHeight Region height available in pixels
+     * @param rowStride Distance between rows in samples (0 = tightly packed)
+     * @return 1 if pixels were written, 0 if the glyph failed or does not fit the region
+     */
+    EMSCRIPTEN_KEEPALIVE
+    int generate_glyph_into(int fontId, uint32_t charCode, double fontSize, double pixelRange, int mode, int format,
+                            void* dest, int destWidth, int destHeight, int rowStride, float* outMetrics) {
+        msdf_core::FontSession* session = getFont(fontId);
+        if (!session) {
             outMetrics[0] = 0.0f;
+            return 0;
+        }
+
+        msdf_core::PixelTarget target;
+        target.data = dest;
+        target.width = destWidth;
+        target.height = destHeight;
+        target.rowStride = rowStride;
+        target.format = format;
+
+        msdf_core::GlyphResult res;
+        bool written = msdf_core::generateInto(
+            *session, mode, charCode, fontSize, pixelRange,
+            g_axesBuffer.data(), (int)g_axesBuffer.size(), target, res, g_raster
+        );
+        writeMetrics(res, outMetrics);
+        return written ? 1 : 0;
+    }
+
+    /**
+     * Pack a charset into one atlas page and render every glyph in place,
+     * using the current variation axes.
+     *
+     * Writes 8 floats per codepoint to outChars, in input order:
+     * [placed, x, y, width, height, xoffset, yoffset, xadvance]
+     * (placed = 0 if the glyph failed to load or did not fit) and the page size to outSize[0..1].
+     * The page is stored in the current output layout (see set_output_layout).
+     *
+     * @param mode 0 = MSDF (3 channels), 1 = MTSDF (4 channels), 2 = SDF (1 channel)
+     * @param format 0 = float32 samples, 1 = uint8
+     * @param maxSize Maximum page width/height in pixels
+     * @return Pointer to the page pixels (owned by WASM, reused across calls), or nullptr on failure
+     */
+    EMSCRIPTEN_KEEPALIVE
+    void* generate_atlas(int fontId, const uint32_t* codepoints, int count, double fontSize, double pixelRange,
+                         int mode, int format, int maxSize, float* outChars, int* outSize) {
+        outSize[0] = outSize[1] = 0;
+        msdf_core::FontSession* session = getFont(fontId);
+        if (!session) {
+            for (int i = 0; i < count; ++i) outChars[i * ATLAS_CHAR_STRIDE] = 0.0f;
             return nullptr;
         }
 
-        outMetrics[0] = 1.0f;
-        outMetrics[1] = (float)res.width;
-        outMetrics[2] = (float)res.height;
-        outMetrics[3] = res.advance;
-        outMetrics[4] = res.planeBounds[0];
-        outMetrics[5] = res.planeBounds[1];
-        outMetrics[6] = res.planeBounds[2];
-        outMetrics[7] = res.planeBounds[3];
-        outMetrics[8] = res.atlasBounds[0];
-        outMetrics[9] = res.atlasBounds[1];
+        msdf_core::AtlasResult atlas = msdf_core::generateAtlas(
+            *session, mode, format, codepoints, count, fontSize, pixelRange, maxSize,
+            g_axesBuffer.data(), (int)g_axesBuffer.size(), g_pixelBuffer, g_byteBuffer, g_raster, g_layout
+        );
+
+        for (int i = 0; i < count; ++i) {
+            writeAtlasChar(atlas.glyphs[i], outChars + i * ATLAS_CHAR_STRIDE);
+        }
+        if (!atlas.success) return nullptr;
+
+        outSize[0] = atlas.width;
+        outSize[1] = atlas.height;
+        return format == msdf_core::FORMAT_UINT8 ? (void*)g_byteBuffer.data() : (void*)g_pixelBuffer.data();
+    }
+
+    /**
+     * generate_atlas for several sizes of the same charset in one page, with the current
+     * variation axes: each glyph is loaded and edge-colored once and rendered at every size.
+     * Writes count * numSizes 8-float char records to outChars, level by level (record
+     * l * count + i is codepoints[i] at fontSizes[l]), and the page size to outSize[0..1].
+     *
+     * @param fontSizes numSizes sizes in pixels (e.g., 128, 64, 32 for a mip chain)
+     * @return Pointer to the page pixels (owned by WASM, reused across calls), or nullptr on failure
+     */
+    EMSCRIPTEN_KEEPALIVE
+    void* generate_atlas_pyramid(int fontId, const uint32_t* codepoints, int count, const double* fontSizes,
+                                 int numSizes, double pixelRange, int mode, int format, int maxSize,
+                                 float* outChars, int* outSize) {
+        outSize[0] = outSize[1] = 0;
+        msdf_core::FontSession* session = getFont(fontId);
+        int records = numSizes > 0 ? count * numSizes : 0;
+        if (!session) {
+            for (int i = 0; i < records; ++i) outChars[i * ATLAS_CHAR_STRIDE] = 0.0f;
+            return nullptr;
+        }
+
+        msdf_core::AtlasResult atlas = msdf_core::generateAtlasPyramid(
+            *session, mode, format, codepoints, count, fontSizes, numSizes, pixelRange, maxSize,
+            g_axesBuffer.data(), (int)g_axesBuffer.size(), g_pixelBuffer, g_byteBuffer, g_raster, g_layout
+        );
+
+        for (int i = 0; i < records; ++i) {
+            writeAtlasChar(atlas.glyphs[i], outChars + i * ATLAS_CHAR_STRIDE);
+        }
+        if (!atlas.success) return nullptr;
+
+        outSize[0] = atlas.width;
+        outSize[1] = atlas.height;
+        return format == msdf_core::FORMAT_UINT8 ? (void*)g_byteBuffer.data() : (void*)g_pixelBuffer.data();
+    }
+
+    /**
+     * Start filling a caller-owned atlas page a few glyphs at a time (see atlas_stream_add).
+     * The page must stay allocated until close_atlas_stream.
+     *
+     * @param page width * height * channels samples of format, rows bottom-to-top, zeroed by the caller
+     * @param mode 0 = MSDF (3 channels), 1 = MTSDF (4 channels), 2 = SDF (1 channel)
+     * @param format 0 = float32 samples, 1 = uint8
+     * @return Stream id (> 0), or 0 for an invalid page
+     */
+    EMSCRIPTEN_KEEPALIVE
+    int open_atlas_stream(void* page, int width, int height, int mode, int format) {
+        if (!page || width <= 0 || height <= 0) return 0;
+        msdf_core::StreamingAtlas* stream = new msdf_core::StreamingAtlas((uint8_t*)page, width, height, mode, format);
+        for (size_t i = 0; i < g_atlasStreams.size(); ++i) {
+            if (!g_atlasStreams[i]) {
+                g_atlasStreams[i] = stream;
+                return (int)i + 1;
+            }
+        }
+        g_atlasStreams.push_back(stream);
+        return (int)g_atlasStreams.size();
+    }
 
-        size_t neededFloats = res.pixels.size();
-        if (g_pixelBuffer.size() < neededFloats) {
-            g_pixelBuffer.resize(neededFloats);
+    /**
+     * Pack and render glyphs into the stream's page with the current variation axes, in the
+     * order given. Slots placed by earlier calls are never touched again, so each new slot
+     * can be uploaded on its own. Writes one 8-float record per codepoint to outChars, as
+     * generate_atlas does (placed = 0 if the glyph failed or the page is full).
+     * @return Number of glyphs placed
+     */
+    EMSCRIPTEN_KEEPALIVE
+    int atlas_stream_add(int streamId, int fontId, const uint32_t* codepoints, int count, double fontSize,
+                         double pixelRange, float* outChars) {
+        msdf_core::StreamingAtlas* stream = getAtlasStream(streamId);
+        msdf_core::FontSession* session = getFont(fontId);
+        if (!stream || !session) {
+            for (int i = 0; i < count; ++i) outChars[i * ATLAS_CHAR_STRIDE] = 0.0f;
+            return 0;
+        }
+        std::vector<msdf_core::AtlasGlyph> glyphs(count);
+        int placed = stream->add(*session, codepoints, count, fontSize, pixelRange,
+                                 g_axesBuffer.data(), (int)g_axesBuffer.size(), glyphs.data(), g_raster);
+        for (int i = 0; i < count; ++i) {
+            writeAtlasChar(glyphs[i], outChars + i * ATLAS_CHAR_STRIDE);
         }
-        std::memcpy(g_pixelBuffer.data(), res.pixels.data(), neededFloats * sizeof(float));
+        return placed;
+    }
+
+    /**
+     * Close an atlas stream. The page itself belongs to the caller. Unknown ids are ignored.
+     */
+    EMSCRIPTEN_KEEPALIVE
+    void close_atlas_stream(int streamId) {
+        msdf_core::StreamingAtlas* stream = getAtlasStream(streamId);
+        if (!stream) return;
+        delete stream;
+        g_atlasStreams[streamId - 1] = nullptr;
+    }
+
+    /**
+     * Persistent cache key of the atlas generate_atlas_file would produce with these arguments,
+     * the current variation axes and raster options: [fontHashLo, fontHashHi, settingsHashLo,
+     * settingsHashHi] to outKey. The font hash covers the font file bytes.
+     * @return 1 if written, 0 for an unknown font
+     */
+    EMSCRIPTEN_KEEPALIVE
+    int atlas_cache_key(int fontId, const uint32_t* codepoints, int count, double fontSize, double pixelRange,
+                        int mode, int format, int maxSize, uint32_t* outKey) {
+        msdf_core::FontSession* session = getFont(fontId);
+        if (!session) return 0;
+        uint64_t settings = msdf_core::atlasSettingsHash(codepoints, count, fontSize, pixelRange, maxSize, mode, format,
+                                                         g_axesBuffer.data(), (int)g_axesBuffer.size(), g_raster,
+                                                         g_layout);
+        outKey[0] = (uint32_t)session->contentHash;
+        outKey[1] = (uint32_t)(session->contentHash >> 32);
+        outKey[2] = (uint32_t)settings;
+        outKey[3] = (uint32_t)(settings >> 32);
+        return 1;
+    }
+
+    /**
+     * generate_atlas, serialized as an atlas file (see msdf_core::AtlasFileHeader): header,
+     * axes, char table and the page, ready to store as-is.
+     * @param outLength Receives the file size in bytes
+     * @return Pointer to the file (owned by WASM, reused across calls), or nullptr on failure
+     */
+    EMSCRIPTEN_KEEPALIVE
+    uint8_t* generate_atlas_file(int fontId, const uint32_t* codepoints, int count, double fontSize, double pixelRange,
+                                 int mode, int format, int maxSize, int* outLength) {
+        outLength[0] = 0;
+        msdf_core::FontSession* session = getFont(fontId);
+        if (!session) return nullptr;
+
+        msdf_core::AtlasResult atlas = msdf_core::generateAtlas(
+            *session, mode, format, codepoints, count, fontSize, pixelRange, maxSize,
+            g_axesBuffer.data(), (int)g_axesBuffer.size(), g_pixelBuffer, g_byteBuffer, g_raster, g_layout
+        );
+        if (!atlas.success) return nullptr;
+
+        uint64_t settings = msdf_core::atlasSettingsHash(codepoints, count, fontSize, pixelRange, maxSize, mode, format,
+                                                         g_axesBuffer.data(), (int)g_axesBuffer.size(), g_raster,
+                                                         g_layout);
+        const void* pixels = format == msdf_core::FORMAT_UINT8 ? (const void*)g_byteBuffer.data()
+                                                               : (const void*)g_pixelBuffer.data();
+        msdf_core::writeAtlasFile(atlas, pixels, mode, format, fontSize, pixelRange, session->contentHash, settings,
+                                  g_axesBuffer.data(), (int)g_axesBuffer.size(), g_fileBuffer, g_layout);
+        outLength[0] = (int)g_fileBuffer.size();
+        return g_fileBuffer.data();
+    }
+
+    /**
+     * Set the number of threads used by generate_batch / generate_atlas (including the caller).
+     * No-op in the single-threaded build. Must not exceed the pthread pool size.
+     */
+    EMSCRIPTEN_KEEPALIVE
+    void set_thread_count(int count) {
+        msdf_core::setThreadCount(count);
+    }
+
+    /**
+     * @return Number of threads used for parallel generation (1 in the single-threaded build)
+     */
+    EMSCRIPTEN_KEEPALIVE
+    int get_thread_count() {
+        return msdf_core::threadCount();
+    }
 
-        return g_pixelBuffer.data();
+    /**
+     * Select the rasterization precision of all generate exports.
+     * @param precision 0 = exact (msdfgen defaults), 1 = fast (see msdf_core::Precision)
+     */
+    EMSCRIPTEN_KEEPALIVE
+    void set_precision(int precision) {
+        g_raster.precision = precision == msdf_core::PRECISION_FAST ? msdf_core::PRECISION_FAST : msdf_core::PRECISION_EXACT;
+    }
+
+    /**
+     * @return Current rasterization precision (0 = exact, 1 = fast)
+     */
+    EMSCRIPTEN_KEEPALIVE
+    int get_precision() {
+        return g_raster.precision;
+    }
+
+    /**
+     * Select the error correction policy of all generate exports (MSDF / MTSDF only).
+     * @param policy 0 = as the precision selects (default), 1 = off, 2 = edge-only,
+     *               3 = full with distance checks, 4 = auto (see msdf_core::ErrorCorrection)
+     */
+    EMSCRIPTEN_KEEPALIVE
+    void set_error_correction(int policy) {
+        g_raster.correction = policy >= msdf_core::CORRECTION_PRECISION && policy <= msdf_core::CORRECTION_AUTO
+            ? policy : msdf_core::CORRECTION_PRECISION;
+    }
+
+    /**
+     * @return Current error correction policy (see set_error_correction)
+     */
+    EMSCRIPTEN_KEEPALIVE
+    int get_error_correction() {
+        return g_raster.correction;
+    }
+
+    /**
+     * Enable band-limited rasterization for all generate exports: distances are computed only
+     * within one distance range of the outline, the rest is filled by an inside/outside test.
+     * SDF uint8 output is unchanged. MSDF / MTSDF channels can differ where a pseudo-distance
+     * along an edge extension reaches past the band, and error correction then sees that far
+     * field, so compare output before enabling it. float32 far samples are clamped to 0 / 1.
+     * @param enabled 1 = sparse, 0 = every pixel (default)
+     */
+    EMSCRIPTEN_KEEPALIVE
+    void set_sparse_raster(int enabled) {
+        g_raster.sparse = enabled != 0;
+    }
+
+    /**
+     * @return 1 if band-limited rasterization is enabled
+     */
+    EMSCRIPTEN_KEEPALIVE
+    int get_sparse_raster() {
+        return g_raster.sparse ? 1 : 0;
+    }
+
+    /**
+     * Enable per-tile contour culling for all generate exports: outlines with three or more
+     * contours are rendered in 16x16 tiles, each against only the contours that can hold a
+     * pixel's nearest edge. Combines with set_sparse_raster.
+     * @param enabled 1 = cull, 0 = every contour for every pixel (default)
+     */
+    EMSCRIPTEN_KEEPALIVE
+    void set_edge_grid(int enabled) {
+        g_raster.grid = enabled != 0;
+    }
+
+    /**
+     * @return 1 if contour culling is enabled
+     */
+    EMSCRIPTEN_KEEPALIVE
+    int get_edge_grid() {
+        return g_raster.grid ? 1 : 0;
+    }
+
+    /**
+     * Select the memory layout of generate_glyph*, generate_batch and generate_atlas* output,
+     * e.g. (1, 256, 1) for WebGPU writeTexture. Caller-owned targets are not affected.
+     * @param topDown 1 = row 0 is the top row, 0 = bottom row (default)
+     * @param rowAlign Row starts are multiples of this many bytes: a power of two up to 4096
+     *                 (1 = tightly packed, default); other values select 1
+     * @param padAlpha 1 = MSDF stored as RGBA with alpha 1.0 / 255, 0 = RGB (default)
+     */
+    EMSCRIPTEN_KEEPALIVE
+    void set_output_layout(int topDown, int rowAlign, int padAlpha) {
+        bool powerOfTwo = rowAlign > 0 && (rowAlign & (rowAlign - 1)) == 0;
+        g_layout.topDown = topDown != 0;
+        g_layout.rowAlign = powerOfTwo && rowAlign <= msdf_core::LAYOUT_MAX_ROW_ALIGN ? rowAlign : 1;
+        g_layout.padAlpha = padAlpha != 0;
+    }
+
+    /**
+     * @return Current output layout as msdf_core::OutputLayout::key(): bit 0 top-down,
+     *         bit 1 padded to RGBA, bits 2+ log2 of the row alignment
+     */
+    EMSCRIPTEN_KEEPALIVE
+    int get_output_layout() {
+        return g_layout.key();
     }
 
     /**
@@ -227,20 +862,189 @@ extern "C" {
      * @return 1 if glyph exists, 0 if not
      */
     EMSCRIPTEN_KEEPALIVE
-    int has_glyph(int fontLen, uint32_t charCode) {
-        return msdf_core::hasGlyph(g_fontBuffer.data(), fontLen, charCode) ? 1 : 0;
+    int has_glyph(int fontId, uint32_t charCode) {
+        msdf_core::FontSession* session = getFont(fontId);
+        if (!session) return 0;
+        return msdf_core::hasGlyph(*session, charCode) ? 1 : 0;
+    }
+
+    /**
+     * Look up many codepoints in the font's cmap in one call (e.g. to pick fallback fonts).
+     * @param outIndices Receives count glyph indices, 0 where the font has no glyph
+     * @return Number of codepoints the font covers, or -1 for an unknown font id
+     */
+    EMSCRIPTEN_KEEPALIVE
+    int get_coverage(int fontId, const uint32_t* codepoints, int count, uint32_t* outIndices) {
+        msdf_core::FontSession* session = getFont(fontId);
+        if (!session) return -1;
+        return msdf_core::glyphCoverage(*session, codepoints, count, outIndices);
+    }
+
+    /**
+     * Font-wide line metrics at fontSize, for the current variation axes, in pixels
+     * on the scale of glyph advances (y up).
+     * @param outMetrics Receives 6 floats: [unitsPerEm, ascender, descender, lineHeight, underlineY, underlineThickness]
+     * @return 1 on success, 0 for an unknown font id or a font without metrics
+     */
+    EMSCRIPTEN_KEEPALIVE
+    int get_font_metrics(int fontId, double fontSize, float* outMetrics) {
+        msdf_core::FontSession* session = getFont(fontId);
+        if (!session) return 0;
+        msdf_core::setSessionAxes(*session, g_axesBuffer.data(), (int)g_axesBuffer.size());
+        msdf_core::LayoutMetrics metrics;
+        if (!msdf_core::layoutMetrics(*session, fontSize, metrics)) return 0;
+        outMetrics[0] = (float)metrics.unitsPerEm;
+        outMetrics[1] = (float)metrics.ascender;
+        outMetrics[2] = (float)metrics.descender;
+        outMetrics[3] = (float)metrics.lineHeight;
+        outMetrics[4] = (float)metrics.underlineY;
+        outMetrics[5] = (float)metrics.underlineThickness;
+        return 1;
+    }
+
+    /**
+     * Kerning of many pairs in one call, from the open face (GPOS 'kern' lookups, else the 'kern' table).
+     * @param pairs Array of count * 2 codes (first, second): codepoints, or glyph indices with bit 31 set
+     * @param outKerning Receives count floats: pixels at fontSize to add to the first glyph's advance
+     * @return Number of pairs with nonzero kerning, or -1 for an unknown font id
+     */
+    EMSCRIPTEN_KEEPALIVE
+    int get_kerning(int fontId, const uint32_t* pairs, int count, double fontSize, float* outKerning) {
+        msdf_core::FontSession* session = getFont(fontId);
+        if (!session) return -1;
+        int kerned = 0;
+        for (int i = 0; i < count; ++i) {
+            outKerning[i] = (float)msdf_core::pairKerning(*session, pairs[i * 2], pairs[i * 2 + 1], fontSize);
+            if (outKerning[i] != 0.0f) kerned++;
+        }
+        return kerned;
+    }
+
+    /**
+     * Every kerned ordered pair of a charset.
+     * @param outPairs Receives up to maxPairs * 2 codes (first, second), first codes in input order
+     * @param outAmounts Receives up to maxPairs floats (pixels at fontSize)
+     * @return Number of kerned pairs; if larger than maxPairs, only the first maxPairs were written.
+     *         -1 for an unknown font id
+     */
+    EMSCRIPTEN_KEEPALIVE
+    int get_kerning_table(int fontId, const uint32_t* codepoints, int count, double fontSize,
+                          uint32_t* outPairs, float* outAmounts, int maxPairs) {
+        msdf_core::FontSession* session = getFont(fontId);
+        if (!session) return -1;
+        return msdf_core::kerningTable(*session, codepoints, count, fontSize, outPairs, outAmounts, maxPairs);
+    }
+
+    /**
+     * Set the glyph cache budget in bytes of pixel data (default 16 MB).
+     * Least recently used glyphs are evicted to fit; 0 disables the cache and empties it.
+     */
+    EMSCRIPTEN_KEEPALIVE
+    void set_glyph_cache_budget(int bytes) {
+        g_glyphCache.setBudget(bytes > 0 ? (size_t)bytes : 0);
+    }
+
+    /**
+     * Drop every cached glyph (stats are kept).
+     */
+    EMSCRIPTEN_KEEPALIVE
+    void clear_glyph_cache() {
+        g_glyphCache.clear();
+    }
+
+    /**
+     * Reset the glyph cache hit / miss / eviction counters.
+     */
+    EMSCRIPTEN_KEEPALIVE
+    void reset_glyph_cache_stats() {
+        g_glyphCache.resetStats();
+    }
+
+    /**
+     * Read glyph cache statistics.
+     * @param out 6 uint32: [hits, misses, evictions, entries, bytes, budget]
+     */
+    EMSCRIPTEN_KEEPALIVE
+    void get_glyph_cache_stats(uint32_t* out) {
+        msdf_core::GlyphCacheStats stats = g_glyphCache.stats();
+        out[0] = stats.hits;
+        out[1] = stats.misses;
+        out[2] = stats.evictions;
+        out[3] = stats.entries;
+        out[4] = (uint32_t)stats.bytes;
+        out[5] = (uint32_t)stats.budget;
+    }
+
+    /**
+     * Read the per-glyph instrumentation (builds with MSDF_STATS, i.e. make STATS=1).
+     *
+     * outTotals receives 10 x 4 bytes:
+     * [enabled, glyphs, shapeCacheHits, glyphCacheHits, recordsHeld] as uint32, then
+     * [allocKB, loadMs, coloringMs, rasterMs, packMs] as float, summed since the last reset_stats.
+     * outRecords receives up to maxRecords of the most recent GlyphStats records (oldest first):
+     * [codepoint, flags, width, height, channels, allocBytes] as uint32, then
+     * [loadUs, coloringUs, rasterUs, packUs] as float.
+     *
+     * @return Number of records written (0 when instrumentation is compiled out)
+     */
+    EMSCRIPTEN_KEEPALIVE
+    int get_stats(uint32_t* outTotals, msdf_core::GlyphStats* outRecords, int maxRecords) {
+        float* outFloats = (float*)outTotals;
+        for (int i = 0; i < 10; ++i) outTotals[i] = 0;
+#ifdef MSDF_STATS
+        msdf_core::StatsTotals totals = msdf_core::statsRing().totals();
+        outTotals[0] = 1;
+        outTotals[1] = (uint32_t)totals.glyphs;
+        outTotals[2] = (uint32_t)totals.shapeCacheHits;
+        outTotals[3] = (uint32_t)totals.glyphCacheHits;
+        outTotals[4] = (uint32_t)msdf_core::statsRing().size();
+        outFloats[5] = (float)(totals.allocBytes / 1024.0);
+        outFloats[6] = (float)(totals.loadUs / 1000.0);
+        outFloats[7] = (float)(totals.coloringUs / 1000.0);
+        outFloats[8] = (float)(totals.rasterUs / 1000.0);
+        outFloats[9] = (float)(totals.packUs / 1000.0);
+        if (!outRecords || maxRecords <= 0) return 0;
+        return msdf_core::statsRing().copyRecent(outRecords, maxRecords);
+#else
+        (void)outFloats;
+        (void)outRecords;
+        (void)maxRecords;
+        return 0;
+#endif
+    }
+
+    /**
+     * Clear the instrumentation ring buffer and totals. No-op without MSDF_STATS.
+     */
+    EMSCRIPTEN_KEEPALIVE
+    void reset_stats() {
+#ifdef MSDF_STATS
+        msdf_core::statsRing().reset();
+#endif
     }
 
     /**
      * Free memory logic.
      * Call this when done with a batch processing job to release heap memory.
+     * Closes every open font.
      */
     EMSCRIPTEN_KEEPALIVE
     void free_buffers() {
+        for (msdf_core::FontSession* session : g_fonts) {
+            msdf_core::closeFont(session);
+        }
+        std::vector<msdf_core::FontSession*>().swap(g_fonts);
+        for (msdf_core::StreamingAtlas* stream : g_atlasStreams) delete stream;
+        std::vector<msdf_core::StreamingAtlas*>().swap(g_atlasStreams);
+        g_glyphCache.clear();
+
         // Force deallocation
         std::vector<uint8_t>().swap(g_fontBuffer);
         std::vector<float>().swap(g_pixelBuffer);
+        std::vector<uint8_t>().swap(g_byteBuffer);
+        std::vector<uint8_t>().swap(g_fileBuffer);
         std::vector<msdf_core::VariationAxis>().swap(g_axesBuffer);
+        msdf_core::glyphScratch().release();
     }
 
 }
\ No newline at end of file
@@ -0,0 +1,61 @@
+/**
+ * libMSDF worker entry - bundled as libMSDF-worker.js. Owns one MSDFGenerator (single-threaded
+ * build) and serves the requests of an MSDFWorker on the main thread.
+ *
+ * Start it as a module worker: new Worker(url, { type: 'module' }).
+ */
+
+import { MSDFGenerator } from './index.js';
+import { WORKER_METHODS, resultTransferables } from './msdf-worker.js';
+import type { WorkerRequest, WorkerResponse } from './msdf-worker.js';
+
+const scope = globalThis as any;
+const methods = new Set<string>(WORKER_METHODS);
+const streams = new Map<number, AbortController>(); // Running streamCharset() requests by id
+
+let generator: MSDFGenerator | null = null;
+
+function reply(response: WorkerResponse, transfer: ArrayBuffer[] = []) {
+    scope.postMessage(response, transfer);
+}
+
+async function handle(request: WorkerRequest): Promise<void> {
+    if (request.type === 'init') {
+        generator = await MSDFGenerator.init(request.modulePath, request.options);
+        reply({ id: request.id, type: 'result', value: null });
+        return;
+    }
+    if (request.type === 'cancel') {
+        streams.get(request.target)?.abort();
+        return;
+    }
+    if (!generator) throw new Error("Worker not initialized");
+
+    if (request.type === 'call') {
+        if (!methods.has(request.method)) throw new Error(`Unknown method: ${request.method}`);
+        const value = (generator as any)[request.method](...request.args);
+        reply({ id: request.id, type: 'result', value }, resultTransferables(value));
+        return;
+    }
+
+    // Stream: slices are posted as they finish; messages that arrive meanwhile run between slices
+    const controller = new AbortController();
+    streams.set(request.id, controller);
+    try {
+        const options = { ...request.options, signal: controller.signal };
+        for await (const slice of generator.streamCharset(request.codepoints, request.fontSize,
+                                                          request.pixelRange, options)) {
+            reply({ id: request.id, type: 'slice', slice }, resultTransferables(slice));
+        }
+        reply({ id: request.id, type: 'result', value: null });
+    } finally {
+        streams.delete(request.id);
+    }
+}
+
+scope.onmessage = (event: MessageEvent<WorkerRequest>) => {
+    const request = event.data;
+    handle(request).catch((error: any) => {
+        reply({ id: request.id, type: 'error', message: String(error?.message ?? error) });
+    });
+};
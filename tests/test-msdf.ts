@@ -3,6 +3,7 @@
  */
 
 import * as fs from 'fs';
+import * as os from 'os';
 import * as path from 'path';
 import { fileURLToPath } from 'url';
 
@@ -31,8 +32,9 @@ async function runTest(name: string, fn: () => Promise<void> | void) {
 async function main() {
     console.log('\n=== libMSDF Test Suite ===\n');
 
-    // Load module
-    const { MSDFGenerator } = await import(path.join(__dirname, 'libMSDF.js'));
+    // Load module (LIBMSDF_MT=1 runs the suite against the threaded build)
+    const bundle = process.env.LIBMSDF_MT ? 'libMSDF-mt' : 'libMSDF';
+    const { MSDFGenerator, FileAtlasStore } = await import(path.join(__dirname, bundle + '.js'));
 
     // Load font
     const fontPath = path.join(__dirname, 'assets/Poppins-Regular.ttf');
@@ -43,15 +45,79 @@ async function main() {
 
     console.log('Init Tests:');
     await runTest('MSDFGenerator.init() loads WASM', async () => {
-        msdf = await MSDFGenerator.init(path.join(__dirname, 'libMSDF.wasm'));
+        msdf = await MSDFGenerator.init(path.join(__dirname, bundle + '.wasm'));
         assert(msdf !== null, 'msdf should not be null');
     });
 
+    await runTest('preload() compiles once; later init() calls reuse the module', async () => {
+        const wasmPath = path.join(__dirname, bundle + '.wasm');
+        await MSDFGenerator.preload(wasmPath);
+        const second = await MSDFGenerator.init(wasmPath);
+        try {
+            second.loadFont(fontBytes);
+            assert(second.generateMTSDF(65, 32, 4) !== null, 'second instance generates');
+        } finally {
+            second.dispose();
+        }
+        let threw = false;
+        try {
+            await MSDFGenerator.init(path.join(__dirname, 'missing.wasm'), { simdModulePath: false });
+        } catch (e) {
+            threw = true;
+        }
+        assert(threw, 'a missing module rejects instead of hanging');
+    });
+
+    await runTest('threadCount matches the build', async () => {
+        if (process.env.LIBMSDF_MT) assert(msdf.threadCount >= 1, 'threaded build has a pool');
+        else assert(msdf.threadCount === 1, 'single-threaded build uses 1 thread');
+    });
+
+    await runTest('SIMD module matches the baseline module', async () => {
+        const simdPath = path.join(__dirname, bundle + '-simd.wasm');
+        if (process.env.LIBMSDF_MT || !fs.existsSync(simdPath)) {
+            assert(msdf.simd === false, 'no SIMD module for this build');
+            return;
+        }
+        assert(msdf.simd === WebAssembly.validate(new Uint8Array([
+            0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0, 10, 10, 1, 8, 0, 65, 0, 253, 15, 253, 98, 11
+        ])), 'SIMD module picked when supported');
+        const baseline = await MSDFGenerator.init(path.join(__dirname, bundle + '.wasm'), { simdModulePath: false });
+        try {
+            assert(baseline.simd === false, 'simdModulePath: false forces the baseline module');
+            msdf.loadFont(fontBytes);
+            baseline.loadFont(fontBytes);
+            for (const format of ['float32', 'uint8']) {
+                const a = msdf.generateMTSDF(65, 48, 6, format);
+                const b = baseline.generateMTSDF(65, 48, 6, format);
+                assert(a.pixels.length === b.pixels.length, 'same sample count');
+                for (let i = 0; i < a.pixels.length; i++) {
+                    if (Math.abs(a.pixels[i] - b.pixels[i]) > (format === 'uint8' ? 1 : 1e-5)) {
+                        throw new Error(`${format} sample ${i}: ${a.pixels[i]} vs ${b.pixels[i]}`);
+                    }
+                }
+            }
+        } finally {
+            baseline.dispose();
+        }
+    });
+
     console.log('\nFont Tests:');
     await runTest('loadFont() accepts font data', async () => {
         msdf.loadFont(fontBytes);
     });
 
+    await runTest('loadFont() rejects invalid font data', async () => {
+        let threw = false;
+        try {
+            msdf.loadFont(new Uint8Array(64));
+        } catch (e) {
+            threw = true;
+        }
+        assert(threw, 'loadFont should throw for non-font bytes');
+        msdf.loadFont(fontBytes); // restore
+    });
+
     await runTest('hasGlyph() returns true for existing glyph', async () => {
         assert(msdf.hasGlyph(65) === true, 'A should exist');
         assert(msdf.hasGlyph(97) === true, 'a should exist');
@@ -61,6 +127,35 @@ async function main() {
         assert(msdf.hasGlyph(0x1F600) === false, 'emoji should not exist');
     });
 
+    await runTest('addFont() keeps several fonts open by handle', async () => {
+        const interPath = path.join(__dirname, 'assets/Inter-VariableFont_opsz,wght.ttf');
+        if (!fs.existsSync(interPath)) return;
+        const poppins = msdf.currentFont;
+        const fd = fs.openSync(interPath, 'r');
+        let inter: number;
+        try {
+            const size = fs.fstatSync(fd).size;
+            inter = msdf.addFontFrom(size, (view: Uint8Array) => { fs.readSync(fd, view, 0, size, 0); });
+        } finally {
+            fs.closeSync(fd);
+        }
+        assert(inter !== poppins && msdf.currentFont === poppins, 'adding does not switch fonts');
+        const a = msdf.generateMTSDF(65, 48, 6);
+        msdf.useFont(inter);
+        const b = msdf.generateMTSDF(65, 48, 6);
+        assert(a.metrics.advance !== b.metrics.advance, 'fonts differ');
+        msdf.useFont(poppins);
+        assert(msdf.generateMTSDF(65, 48, 6).metrics.advance === a.metrics.advance, 'switching back');
+        msdf.closeFont(inter);
+        let threw = false;
+        try {
+            msdf.useFont(inter);
+        } catch (e) {
+            threw = true;
+        }
+        assert(threw, 'closed handle is rejected');
+    });
+
     console.log('\nGeneration Tests:');
     await runTest('generate() returns valid 3-channel MSDF', async () => {
         const glyph = msdf.generate(65, 64, 8);
@@ -77,12 +172,384 @@ async function main() {
         assert(glyph.pixels.length === glyph.metrics.width * glyph.metrics.height * 4, '4 channels');
     });
 
+    await runTest('generateSDF() matches the MTSDF true-distance channel', async () => {
+        const sdf = msdf.generateSDF(65, 48, 6);
+        const mtsdf = msdf.generateMTSDF(65, 48, 6);
+        assert(sdf !== null, 'glyph should not be null');
+        assert(sdf.metrics.width === mtsdf.metrics.width && sdf.metrics.height === mtsdf.metrics.height, 'same frame');
+        assert(sdf.pixels.length === sdf.metrics.width * sdf.metrics.height, '1 channel');
+        for (let i = 0; i < sdf.pixels.length; i++) {
+            if (Math.abs(sdf.pixels[i] - mtsdf.pixels[i * 4 + 3]) > 1e-3) throw new Error(`pixel ${i} differs`);
+        }
+        const batch = msdf.generateBatch([65], 48, 6, 'sdf', 'uint8');
+        assert(batch[0] !== null && batch[0].pixels.length === sdf.pixels.length, 'batch accepts sdf mode');
+    });
+
+    await runTest('uint8 format matches quantized float output', async () => {
+        const f = msdf.generateMTSDF(65, 48, 6);
+        const q = msdf.generateMTSDF(65, 48, 6, 'uint8');
+        assert(q.pixels instanceof Uint8Array, 'pixels is Uint8Array');
+        assert(q.pixels.length === f.pixels.length, 'same sample count');
+        for (let i = 0; i < f.pixels.length; i++) {
+            const expected = Math.round(Math.min(Math.max(f.pixels[i], 0), 1) * 255);
+            if (Math.abs(q.pixels[i] - expected) > 1) throw new Error(`sample ${i}: ${q.pixels[i]} vs ${expected}`);
+        }
+    });
+
     await runTest('different sizes produce different dimensions', async () => {
         const small = msdf.generate(65, 32, 8);
         const large = msdf.generate(65, 128, 8);
         assert(small.metrics.width < large.metrics.width, 'small < large');
     });
 
+    await runTest('generateBatch() matches single-glyph generation', async () => {
+        const codes = [65, 97, 32];
+        const batch = msdf.generateBatch(codes, 48, 6, 'mtsdf');
+        assert(batch.length === codes.length, 'one result per codepoint');
+        const single = msdf.generateMTSDF(97, 48, 6);
+        const a = batch[1];
+        assert(a !== null, 'a should not be null');
+        assert(a.metrics.width === single.metrics.width && a.metrics.height === single.metrics.height, 'same dimensions');
+        assert(a.pixels.length === single.pixels.length, 'same pixel count');
+        for (let i = 0; i < a.pixels.length; i++) {
+            if (a.pixels[i] !== single.pixels[i]) throw new Error(`pixel ${i} differs`);
+        }
+    });
+
+    await runTest('streamCharset() yields every glyph in slices, priority first', async () => {
+        const codes = Array.from('abcdefghijklmnopqrstuvwxyz', c => c.codePointAt(0)!);
+        const order: number[] = [];
+        let slices = 0;
+        for await (const slice of msdf.streamCharset([...codes, 97], 47, 6, { priority: [122, 121], sliceMs: 1 })) {
+            assert(slice.codepoints.length === slice.glyphs.length, 'one glyph per codepoint');
+            order.push(...slice.codepoints);
+            slices++;
+        }
+        assert(order.length === codes.length, 'each codepoint once');
+        assert(order[0] === 122 && order[1] === 121, 'priority codepoints first');
+        assert(slices > 1, 'work split into slices');
+
+        const glyphs = await msdf.generateAsync([65, 97], 48, 6);
+        const single = msdf.generateBatch([65, 97], 48, 6);
+        for (let g = 0; g < 2; g++) {
+            assert(glyphs[g] !== null && glyphs[g]!.pixels.length === single[g]!.pixels.length, 'same as generateBatch()');
+        }
+    });
+
+    await runTest('measureGlyphs() matches generated metrics without rasterizing', async () => {
+        const codes = [0x7E, 0x40, 0xDF, 0x20]; // '~', '@', 'ß', space: outlines not loaded by earlier tests
+        const measured = msdf.measureGlyphs(codes, 37, 5); // outlines loaded and bounded only
+        const glyphs = msdf.generateBatch(codes, 37, 5, 'msdf', 'uint8');
+        const remeasured = msdf.measureGlyphs(codes, 37, 5); // outlines now cached
+        codes.forEach((code, i) => {
+            assert(measured[i] !== null && glyphs[i] !== null, `${code} loads`);
+            assert(JSON.stringify(measured[i]) === JSON.stringify(glyphs[i]!.metrics), `${code}: same metrics as generateBatch()`);
+            assert(JSON.stringify(remeasured[i]) === JSON.stringify(measured[i]), `${code}: same metrics from the outline cache`);
+        });
+    });
+
+    await runTest('getCoverage() and generateByGlyphIndex() skip the cmap', async () => {
+        const coverage = msdf.getCoverage([65, 97, 0x1F600]);
+        assert(coverage.length === 3, 'one index per codepoint');
+        assert(coverage[0] !== 0 && coverage[1] !== 0 && coverage[2] === 0, 'A and a covered, emoji missing');
+        const byIndex = msdf.generateByGlyphIndex(coverage[0], 48, 6, 'mtsdf');
+        const byCode = msdf.generateMTSDF(65, 48, 6);
+        assert(byIndex !== null && byIndex.pixels.length === byCode.pixels.length, 'same size as by codepoint');
+        for (let i = 0; i < byCode.pixels.length; i++) {
+            if (byIndex.pixels[i] !== byCode.pixels[i]) throw new Error(`pixel ${i} differs`);
+        }
+    });
+
+    await runTest('getFontMetrics() and getKerning() read layout data from the open font', async () => {
+        const em = msdf.getFontMetrics(1);
+        const big = msdf.getFontMetrics(40);
+        assert(em.unitsPerEm > 0 && em.ascender > 0 && em.descender < 0, 'ascender up, descender down');
+        assert(em.lineHeight >= em.ascender - em.descender - 1e-3, 'line height covers the line');
+        assert(Math.abs(big.ascender - em.ascender * 40) < 1e-3, 'scales with fontSize');
+        const AV = [65, 86], AA = [65, 65];
+        const kerning = msdf.getKerning([AV, AA], 40);
+        assert(kerning[0] < 0 && kerning[1] === 0, 'AV kerned closer, AA not');
+        const index = msdf.getCoverage([65, 86]);
+        const byIndex = msdf.getKerning([[0x80000000 | index[0], 0x80000000 | index[1]]], 40);
+        assert(byIndex[0] === kerning[0], 'glyph indices kern like codepoints');
+        const table = msdf.getKerningTable(Array.from('AVTo', c => c.codePointAt(0)!), 40);
+        const pair = table.find((p: any) => p.first === 65 && p.second === 86);
+        assert(pair !== undefined && pair.amount === kerning[0], 'table has AV');
+        assert(table.every((p: any) => p.amount !== 0), 'only kerned pairs');
+    });
+
+    await runTest('generateAtlas() packs glyphs without overlap', async () => {
+        const codes = Array.from('ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789 ', c => c.codePointAt(0)!);
+        const atlas = msdf.generateAtlas(codes, 48, 6, 1024, 'mtsdf');
+        assert(atlas !== null, 'atlas should not be null');
+        assert(atlas.missing.length === 0, 'all glyphs placed');
+        assert(atlas.chars.length === codes.length, 'one char per codepoint');
+        assert(atlas.pixels.length === atlas.width * atlas.height * 4, '4 channels');
+        const rects = atlas.chars.filter((c: any) => c.width > 0);
+        for (const a of rects) {
+            assert(a.x >= 0 && a.y >= 0 && a.x + a.width <= atlas.width && a.y + a.height <= atlas.height, 'inside page');
+            for (const b of rects) {
+                if (a === b) continue;
+                const overlap = a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+                assert(!overlap, `chars ${a.id} and ${b.id} overlap`);
+            }
+        }
+        const single = msdf.generateMTSDF(65, 48, 6);
+        const A = atlas.chars.find((c: any) => c.id === 65);
+        assert(A.width === single.metrics.width && A.height === single.metrics.height, 'same size as single glyph');
+    });
+
+    await runTest('generateAtlasCached() stores the atlas file and reads it back', async () => {
+        const codes = Array.from('libMSDF ', c => c.codePointAt(0)!);
+        const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'libmsdf-'));
+        try {
+            const store = new FileAtlasStore(dir);
+            const key = msdf.atlasCacheKey(codes, 32, 4, 512, 'mtsdf', 'uint8');
+            assert(key !== msdf.atlasCacheKey(codes, 33, 4, 512, 'mtsdf', 'uint8'), 'size is part of the key');
+            const cold = await msdf.generateAtlasCached(store, codes, 32, 4, 512, 'mtsdf', 'uint8');
+            assert(cold !== null && cold.key === key, 'generated under its key');
+            assert(fs.existsSync(path.join(dir, key + '.msda')), 'file written');
+            const warm = await msdf.generateAtlasCached(store, codes, 32, 4, 512, 'mtsdf', 'uint8');
+            const direct = msdf.generateAtlas(codes, 32, 4, 512, 'mtsdf', 'uint8');
+            assert(warm.width === direct.width && warm.height === direct.height, 'same page size');
+            assert(JSON.stringify(warm.chars) === JSON.stringify(direct.chars), 'same char table');
+            for (let i = 0; i < direct.pixels.length; i++) {
+                if (warm.pixels[i] !== direct.pixels[i]) throw new Error(`pixel ${i} differs`);
+            }
+        } finally {
+            fs.rmSync(dir, { recursive: true, force: true });
+        }
+    });
+
+    await runTest('generateAtlasPyramid() matches single glyphs at every level', async () => {
+        const codes = Array.from('AB ', c => c.codePointAt(0)!);
+        const pyramid = msdf.generateAtlasPyramid(codes, [64, 32], 4, 512, 'msdf', 'uint8');
+        assert(pyramid !== null && pyramid.levels.length === 2, 'one level per size');
+        assert(pyramid.levels[1].fontSize === 32 && pyramid.levels[1].missing.length === 0, 'all glyphs placed');
+        const big = pyramid.levels[0].chars.find((c: any) => c.id === 65);
+        const A = pyramid.levels[1].chars.find((c: any) => c.id === 65);
+        assert(big.width > A.width && (big.x !== A.x || big.y !== A.y), 'separate slots per level');
+        const single = msdf.generate(65, 32, 4, 'uint8');
+        assert(A.width === single.metrics.width && A.height === single.metrics.height, 'same size as single glyph');
+        for (let y = 0; y < A.height; y++) {
+            for (let i = 0; i < A.width * 3; i++) {
+                const got = pyramid.pixels[(A.y + y) * pyramid.rowStride + A.x * 3 + i];
+                if (got !== single.pixels[y * single.rowStride + i]) throw new Error(`row ${y} differs`);
+            }
+        }
+    });
+
+    await runTest('streamAtlas() reports final page regions, priority first', async () => {
+        const codes = Array.from('ABCDEFGHIJKLMNOPQRSTUVWXYZ ', c => c.codePointAt(0)!);
+        const page = msdf.createStagingBuffer(256, 256, 'mtsdf', 'uint8');
+        try {
+            const updates: any[] = [];
+            for await (const update of msdf.streamAtlas(page, codes, 32, 4, { priority: [90], sliceMs: 1 })) {
+                updates.push(update);
+            }
+            assert(updates.length === codes.length && updates[0].glyphId === 90, 'every glyph once, Z first');
+            const rects = updates.map(u => u.rect).filter((r: any) => r && r.width > 0);
+            assert(rects.length === codes.length - 1, 'all but space placed with a bitmap');
+            for (const a of rects) {
+                assert(a.x + a.width <= page.width && a.y + a.height <= page.height, 'inside page');
+                for (const b of rects) {
+                    if (a === b) continue;
+                    const overlap = a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+                    assert(!overlap, 'regions do not overlap');
+                }
+            }
+            const single = msdf.generateMTSDF(90, 32, 4, 'uint8');
+            const rect = updates[0].rect;
+            const view = page.view();
+            for (let y = 0; y < rect.height; y++) {
+                for (let i = 0; i < rect.width * 4; i++) {
+                    const got = view[((rect.y + y) * page.width + rect.x) * 4 + i];
+                    if (got !== single.pixels[y * rect.width * 4 + i]) throw new Error(`Z differs at row ${y}`);
+                }
+            }
+        } finally {
+            page.free();
+        }
+    });
+
+    await runTest('generateInto() writes in place into a staging buffer', async () => {
+        const single = msdf.generateMTSDF(65, 48, 6, 'uint8');
+        const staging = msdf.createStagingBuffer(128, 128, 'mtsdf', 'uint8');
+        try {
+            const res = msdf.generateInto(65, staging, 10, 20, 48, 6);
+            assert(res !== null && res.written, 'glyph written');
+            const { width, height } = res.metrics;
+            assert(width === single.metrics.width && height === single.metrics.height, 'same size as single glyph');
+            const view = staging.view();
+            for (let y = 0; y < height; y++) {
+                for (let i = 0; i < width * 4; i++) {
+                    const got = view[((y + 20) * 128 + 10) * 4 + i];
+                    if (got !== single.pixels[y * width * 4 + i]) throw new Error(`pixel (${i >> 2}, ${y}) differs`);
+                }
+            }
+            const tooClose = msdf.generateInto(65, staging, 127, 127, 48, 6);
+            assert(tooClose !== null && !tooClose.written, 'reports when the glyph does not fit');
+        } finally {
+            staging.free();
+        }
+    });
+
+    await runTest('glyph cache serves repeated requests', async () => {
+        msdf.clearCache();
+        msdf.resetCacheStats();
+        const first = msdf.generateMTSDF(66, 40, 4);
+        const second = msdf.generateMTSDF(66, 40, 4);
+        msdf.generate(66, 40, 4); // different mode: separate entry
+        const stats = msdf.getCacheStats();
+        assert(stats.hits === 1 && stats.misses === 2, `1 hit / 2 misses (got ${stats.hits} / ${stats.misses})`);
+        assert(stats.entries === 2 && stats.bytes > 0, 'two entries cached');
+        assert(second.metrics.advance === first.metrics.advance, 'same metrics');
+        for (let i = 0; i < first.pixels.length; i++) {
+            if (first.pixels[i] !== second.pixels[i]) throw new Error(`pixel ${i} differs`);
+        }
+        msdf.setCacheBudget(0);
+        assert(msdf.getCacheStats().entries === 0, 'budget 0 empties the cache');
+        msdf.setCacheBudget(16 * 1024 * 1024);
+    });
+
+    await runTest('reused outlines give identical output across sizes and modes', async () => {
+        msdf.setCacheBudget(0); // force regeneration from the shape cache
+        const first = msdf.generateMTSDF(67, 48, 6);
+        msdf.generate(67, 24, 4);
+        msdf.generateMTSDF(67, 96, 8);
+        const again = msdf.generateMTSDF(67, 48, 6);
+        assert(again.metrics.width === first.metrics.width && again.metrics.height === first.metrics.height, 'same size');
+        for (let i = 0; i < first.pixels.length; i++) {
+            if (first.pixels[i] !== again.pixels[i]) throw new Error(`pixel ${i} differs`);
+        }
+        msdf.setCacheBudget(16 * 1024 * 1024);
+    });
+
+    await runTest('getStats() reports per-glyph stages when compiled in', async () => {
+        msdf.resetStats();
+        msdf.setCacheBudget(0);
+        msdf.generateMTSDF(72, 40, 4, 'uint8');
+        const stats = msdf.getStats();
+        if (!stats.enabled) {
+            assert(stats.glyphs === 0 && stats.records.length === 0, 'nothing recorded without STATS=1');
+        } else {
+            assert(stats.glyphs === 1 && stats.records.length === 1, 'one glyph recorded');
+            const r = stats.records[0];
+            assert(r.codepoint === 72 && r.channels === 4 && r.uint8, 'record describes the call');
+            assert(r.width > 0 && r.height > 0 && r.rasterUs > 0, 'dimensions and raster time');
+        }
+        msdf.setCacheBudget(16 * 1024 * 1024);
+    });
+
+    await runTest("'fast' precision stays close to 'exact'", async () => {
+        assert(msdf.precision === 'exact', 'exact by default');
+        const exact = msdf.generateMTSDF(82, 48, 4, 'uint8');
+        msdf.setPrecision('fast');
+        try {
+            assert(msdf.precision === 'fast', 'precision switched');
+            const fast = msdf.generateMTSDF(82, 48, 4, 'uint8'); // separate cache entry
+            assert(fast.metrics.width === exact.metrics.width && fast.metrics.height === exact.metrics.height, 'same size');
+            let far = 0;
+            for (let i = 0; i < exact.pixels.length; i++) {
+                if (Math.abs(fast.pixels[i] - exact.pixels[i]) > 16) far++;
+            }
+            assert(far <= exact.pixels.length / 50, `at most 2% of samples differ noticeably (got ${far})`);
+        } finally {
+            msdf.setPrecision('exact');
+        }
+    });
+
+    await runTest("setErrorCorrection('auto') skips correction only for glyphs without corners", async () => {
+        const render = (policy: string, code: number) => {
+            msdf.setErrorCorrection(policy);
+            return msdf.generateMTSDF(code, 48, 4, 'uint8').pixels;
+        };
+        const same = (a: Uint8Array, b: Uint8Array, what: string) => {
+            assert(a.length === b.length, `${what}: same size`);
+            for (let i = 0; i < a.length; i++) {
+                if (a[i] !== b[i]) throw new Error(`${what}: pixel ${i} differs`);
+            }
+        };
+        try {
+            same(render('auto', 79), render('off', 79), "'O' auto vs off");
+            same(render('auto', 65), render('default', 65), "'A' auto vs default");
+            assert(msdf.errorCorrection === 'default', 'policy reads back');
+            for (const policy of ['edge-only', 'full']) {
+                assert(render(policy, 65).length === render('default', 65).length, `${policy}: same size`);
+            }
+        } finally {
+            msdf.setErrorCorrection('default');
+        }
+    });
+
+    await runTest('sparse rasterization stays close to dense uint8 output', async () => {
+        const dense = msdf.generateMTSDF(79, 160, 4, 'uint8');
+        msdf.setSparseRaster(true);
+        try {
+            assert(msdf.sparseRaster, 'sparse enabled');
+            const sparse = msdf.generateMTSDF(79, 160, 4, 'uint8'); // separate cache entry
+            assert(sparse.metrics.width === dense.metrics.width && sparse.metrics.height === dense.metrics.height, 'same size');
+            let differ = 0;
+            for (let i = 0; i < dense.pixels.length; i++) {
+                if (Math.abs(sparse.pixels[i] - dense.pixels[i]) > 1) differ++;
+            }
+            assert(differ <= dense.pixels.length / 100, `at most 1% of samples differ (got ${differ})`);
+        } finally {
+            msdf.setSparseRaster(false);
+        }
+    });
+
+    await runTest('contour culling matches unculled uint8 output', async () => {
+        const glyphs = [37, 56, 66]; // '%', '8', 'B': three or more contours each
+        const dense = glyphs.map(code => msdf.generate(code, 96, 4, 'uint8'));
+        msdf.setEdgeGrid(true);
+        try {
+            assert(msdf.edgeGrid, 'culling enabled');
+            glyphs.forEach((code, g) => {
+                const culled = msdf.generate(code, 96, 4, 'uint8'); // separate cache entry
+                assert(culled.pixels.length === dense[g].pixels.length, 'same size');
+                let differ = 0;
+                for (let i = 0; i < culled.pixels.length; i++) {
+                    if (Math.abs(culled.pixels[i] - dense[g].pixels[i]) > 1) differ++;
+                }
+                assert(differ <= culled.pixels.length / 100, `at most 1% of samples differ for ${code} (got ${differ})`);
+            });
+        } finally {
+            msdf.setEdgeGrid(false);
+        }
+    });
+
+    await runTest('setOutputLayout() writes top-down, row-aligned RGBA', async () => {
+        const packed = msdf.generate(65, 48, 4, 'uint8');
+        const { width, height } = packed.metrics;
+        msdf.setOutputLayout({ topDown: true, rowAlignment: 256, padToRGBA: true });
+        try {
+            const glyph = msdf.generate(65, 48, 4, 'uint8'); // separate cache entry
+            assert(glyph.channels === 4 && glyph.rowStride % 256 === 0 && glyph.rowStride >= width * 4, 'aligned RGBA rows');
+            assert(glyph.pixels.length === glyph.rowStride * height, 'rowStride * height samples');
+            for (let y = 0; y < height; y++) {
+                for (let x = 0; x < width; x++) {
+                    const got = glyph.pixels.subarray((height - 1 - y) * glyph.rowStride + x * 4, (height - 1 - y) * glyph.rowStride + x * 4 + 4);
+                    const want = packed.pixels.subarray((y * width + x) * 3, (y * width + x) * 3 + 3);
+                    if (got[0] !== want[0] || got[1] !== want[1] || got[2] !== want[2] || got[3] !== 255) {
+                        throw new Error(`pixel (${x}, ${y}) differs`);
+                    }
+                }
+            }
+            const atlas = msdf.generateAtlas([65, 66], 48, 4, 512, 'msdf', 'uint8');
+            assert(atlas.channels === 4 && atlas.rowStride % 256 === 0, 'atlas in the same layout');
+            const A = atlas.chars.find((c: any) => c.id === 65);
+            for (let y = 0; y < height; y++) {
+                for (let i = 0; i < width * 4; i++) {
+                    const got = atlas.pixels[(A.y + y) * atlas.rowStride + A.x * 4 + i];
+                    if (got !== glyph.pixels[y * glyph.rowStride + i]) throw new Error(`atlas row ${y} differs`);
+                }
+            }
+        } finally {
+            msdf.setOutputLayout({ topDown: false, rowAlignment: 1, padToRGBA: false });
+        }
+    });
+
     // Variable font tests
     console.log('\nVariable Font Tests:');
     const interPath = path.join(__dirname, 'assets/Inter-VariableFont_opsz,wght.ttf');
@@ -98,6 +565,42 @@ async function main() {
             assert(bold.metrics.advance > thin.metrics.advance, 'bold wider than thin');
             msdf.loadFont(fontBytes); // restore
         });
+
+        await runTest('axes are set by tag (opsz, unknown tags ignored)', async () => {
+            msdf.loadFont(interBytes);
+            msdf.setVariationAxes([{ tag: 'opsz', value: 14 }]);
+            const text = msdf.generateMTSDFVar(97, 64, 8);
+            msdf.setVariationAxes([{ tag: 'opsz', value: 32 }, { tag: 'GRAD', value: 50 }]);
+            const display = msdf.generateMTSDFVar(97, 64, 8);
+            let differ = text.pixels.length !== display.pixels.length;
+            for (let i = 0; !differ && i < text.pixels.length; i++) differ = text.pixels[i] !== display.pixels[i];
+            assert(differ, 'opsz changes the outline');
+            msdf.clearVariationAxes();
+            msdf.loadFont(fontBytes); // restore
+        });
+
+        await runTest('quantized axes reuse cached instances', async () => {
+            msdf.loadFont(interBytes);
+            msdf.setVariationStep(10, 'wght');
+            try {
+                msdf.resetCacheStats();
+                msdf.setVariationAxes([{ tag: 'wght', value: 401 }, { tag: 'opsz', value: 20 }]);
+                const a = msdf.generateMTSDFVar(66, 48, 4);
+                msdf.setVariationAxes([{ tag: 'wght', value: 404 }, { tag: 'opsz', value: 20 }]); // same instance
+                const b = msdf.generateMTSDFVar(66, 48, 4);
+                msdf.setVariationAxes([{ tag: 'wght', value: 406 }, { tag: 'opsz', value: 20 }]); // next step
+                msdf.generateMTSDFVar(66, 48, 4);
+                const stats = msdf.getCacheStats();
+                assert(stats.hits === 1 && stats.misses === 2, `1 hit / 2 misses (got ${stats.hits} / ${stats.misses})`);
+                for (let i = 0; i < a.pixels.length; i++) {
+                    if (a.pixels[i] !== b.pixels[i]) throw new Error(`pixel ${i} differs`);
+                }
+            } finally {
+                msdf.setVariationStep(0, 'wght');
+                msdf.clearVariationAxes();
+                msdf.loadFont(fontBytes); // restore
+            }
+        });
     } else {
         console.log('  SKIP: Inter variable font not found');
     }
@@ -105,7 +608,7 @@ async function main() {
     // Summary
     console.log('\n=== Summary ===');
     console.log(`Tests: ${passed} passed, ${failed} failed`);
-    if (failed > 0) process.exit(1);
+    process.exit(failed > 0 ? 1 : 0); // Explicit: pthread workers would keep Node alive
 }
 
 main().catch(e => {
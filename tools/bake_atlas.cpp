@@ -0,0 +1,564 @@
+// Offline atlas baker for build pipelines: generateAtlasFile() without Node or WASM.
+// Build with: make -f Makefile.native bake
+//
+// Every combination of font, charset, size and mode is one job, written to the output directory as
+//   <font>-<charset>-<size>-<mode>.msda   atlas file (atlas_file.h), readable with parseAtlasFile()
+//   <font>-<charset>-<size>-<mode>.json   BMFont-style char table, line metrics and kerning
+//   <font>-<charset>-<size>-<mode>.png    the page (uint8 only, unless --no-png)
+// A job is skipped when its atlas file already carries the font hash and settings hash of its
+// inputs, so a re-run only bakes what changed. Jobs run one per core; builds with THREADS=1 run
+// them one after the other instead, each atlas spread over the work-stealing pool.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+#include "core.h"
+#include "atlas.h"
+#include "atlas_file.h"
+#include "thread_pool.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static bool readFile(const std::string& path, std::vector<uint8_t>& out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    out.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !out.empty();
+}
+
+// Written under a temporary name and renamed, so an interrupted run never leaves a partial file
+static bool writeFile(const std::string& path, const void* data, size_t length) {
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+        file.write((const char*)data, (std::streamsize)length);
+        if (!file) return false;
+    }
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+static bool writeFile(const std::string& path, const std::string& text) {
+    return writeFile(path, text.data(), text.size());
+}
+
+// File name without directory and extension
+static std::string fileStem(const char* path) {
+    return std::filesystem::path(path).stem().string();
+}
+
+struct FontInput {
+    std::string name;
+    std::vector<uint8_t> data;
+    uint64_t hash;              // hashBytes of the file, as FontSession::contentHash
+};
+
+struct Charset {
+    std::string name;
+    std::vector<uint32_t> codepoints;
+};
+
+struct Options {
+    std::vector<double> sizes = {32};
+    std::vector<int> modes = {msdf_core::MODE_MTSDF};
+    double pixelRange = 4.0;
+    int maxSize = 2048;
+    int format = msdf_core::FORMAT_UINT8;
+    msdf_core::RasterOptions raster;
+    std::vector<msdf_core::VariationAxis> axes;
+    std::vector<const char*> fonts;
+    std::vector<const char*> charsets;
+    std::string outDir = ".";
+    int jobs = 0;               // 0 = one per logical core
+    bool png = true;            // uint8 only: --format float32 turns it off
+    bool force = false;
+};
+
+static const char* const MODE_NAMES[] = { "msdf", "mtsdf", "sdf" };
+
+static void usage() {
+    std::fprintf(stderr,
+        "usage: bake_atlas [--out DIR] [--charset FILE]... [--sizes 32,48,...] [--modes msdf,mtsdf,sdf] [--range R]\n"
+        "                  [--max-size N] [--format uint8|float32] [--no-png] [--axes wght=700,...] [--precision exact|fast]\n"
+        "                  [--correction off|edge|full|auto] [--sparse] [--grid] [--jobs N] [--force] font.ttf...\n");
+}
+
+static bool parseMode(const char* name, int& mode) {
+    for (int i = 0; i < 3; ++i) {
+        if (!std::strcmp(name, MODE_NAMES[i])) {
+            mode = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// "wght=700": 4-letter tag and value
+static bool parseAxis(const char* text, msdf_core::VariationAxis& axis) {
+    const char* equals = std::strchr(text, '=');
+    if (!equals || equals - text != 4) return false;
+    std::memcpy(axis.tag, text, 4);
+    axis.tag[4] = '\0';
+    axis.value = std::atof(equals + 1);
+    return true;
+}
+
+static bool parseArgs(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(arg, "--out") && hasValue) {
+            opt.outDir = argv[++i];
+        } else if (!std::strcmp(arg, "--charset") && hasValue) {
+            opt.charsets.push_back(argv[++i]);
+        } else if (!std::strcmp(arg, "--sizes") && hasValue) {
+            opt.sizes.clear();
+            for (char* token = std::strtok(argv[++i], ","); token; token = std::strtok(nullptr, ",")) {
+                opt.sizes.push_back(std::atof(token));
+            }
+        } else if (!std::strcmp(arg, "--modes") && hasValue) {
+            opt.modes.clear();
+            for (char* token = std::strtok(argv[++i], ","); token; token = std::strtok(nullptr, ",")) {
+                int mode;
+                if (!parseMode(token, mode)) return false;
+                opt.modes.push_back(mode);
+            }
+        } else if (!std::strcmp(arg, "--range") && hasValue) {
+            opt.pixelRange = std::atof(argv[++i]);
+        } else if (!std::strcmp(arg, "--max-size") && hasValue) {
+            opt.maxSize = std::atoi(argv[++i]);
+        } else if (!std::strcmp(arg, "--format") && hasValue) {
+            const char* format = argv[++i];
+            if (!std::strcmp(format, "uint8")) opt.format = msdf_core::FORMAT_UINT8;
+            else if (!std::strcmp(format, "float32")) opt.format = msdf_core::FORMAT_FLOAT32;
+            else return false;
+        } else if (!std::strcmp(arg, "--no-png")) {
+            opt.png = false;
+        } else if (!std::strcmp(arg, "--axes") && hasValue) {
+            for (char* token = std::strtok(argv[++i], ","); token; token = std::strtok(nullptr, ",")) {
+                msdf_core::VariationAxis axis;
+                if (!parseAxis(token, axis)) return false;
+                opt.axes.push_back(axis);
+            }
+        } else if (!std::strcmp(arg, "--precision") && hasValue) {
+            const char* precision = argv[++i];
+            if (!std::strcmp(precision, "exact")) opt.raster.precision = msdf_core::PRECISION_EXACT;
+            else if (!std::strcmp(precision, "fast")) opt.raster.precision = msdf_core::PRECISION_FAST;
+            else return false;
+        } else if (!std::strcmp(arg, "--correction") && hasValue) {
+            const char* correction = argv[++i];
+            if (!std::strcmp(correction, "off")) opt.raster.correction = msdf_core::CORRECTION_OFF;
+            else if (!std::strcmp(correction, "edge")) opt.raster.correction = msdf_core::CORRECTION_EDGE_ONLY;
+            else if (!std::strcmp(correction, "full")) opt.raster.correction = msdf_core::CORRECTION_FULL;
+            else if (!std::strcmp(correction, "auto")) opt.raster.correction = msdf_core::CORRECTION_AUTO;
+            else return false;
+        } else if (!std::strcmp(arg, "--sparse")) {
+            opt.raster.sparse = true;
+        } else if (!std::strcmp(arg, "--grid")) {
+            opt.raster.grid = true;
+        } else if (!std::strcmp(arg, "--jobs") && hasValue) {
+            opt.jobs = std::max(1, std::atoi(argv[++i]));
+        } else if (!std::strcmp(arg, "--force")) {
+            opt.force = true;
+        } else if (arg[0] == '-') {
+            return false;
+        } else {
+            opt.fonts.push_back(arg);
+        }
+    }
+    if (opt.format != msdf_core::FORMAT_UINT8) opt.png = false;
+    return !opt.fonts.empty() && !opt.sizes.empty() && !opt.modes.empty() && opt.pixelRange > 0 && opt.maxSize > 0;
+}
+
+/**
+ * Distinct codepoints of a UTF-8 text file, ascending, so reordering the file does not
+ * change the atlas. Line breaks and other control characters are dropped; a byte order
+ * mark and malformed sequences are skipped.
+ */
+static bool readCharset(const char* path, std::vector<uint32_t>& out) {
+    std::vector<uint8_t> text;
+    if (!readFile(path, text)) return false;
+    size_t i = text.size() >= 3 && text[0] == 0xEF && text[1] == 0xBB && text[2] == 0xBF ? 3 : 0;
+    while (i < text.size()) {
+        uint8_t lead = text[i];
+        uint32_t codepoint;
+        int extra;
+        if (lead < 0x80) { codepoint = lead; extra = 0; }
+        else if ((lead & 0xE0) == 0xC0) { codepoint = lead & 0x1F; extra = 1; }
+        else if ((lead & 0xF0) == 0xE0) { codepoint = lead & 0x0F; extra = 2; }
+        else if ((lead & 0xF8) == 0xF0) { codepoint = lead & 0x07; extra = 3; }
+        else { ++i; continue; }
+
+        bool valid = i + extra < text.size();
+        for (int k = 1; valid && k <= extra; ++k) {
+            if ((text[i + k] & 0xC0) != 0x80) valid = false;
+            else codepoint = codepoint << 6 | (text[i + k] & 0x3F);
+        }
+        i += valid ? extra + 1 : 1;
+        if (valid && codepoint >= 0x20 && codepoint != 0x7F && !(codepoint >= 0x80 && codepoint < 0xA0)) {
+            out.push_back(codepoint);
+        }
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+    return !out.empty();
+}
+
+// Printable ASCII, space included: the charset when no --charset is given
+static Charset asciiCharset() {
+    Charset charset;
+    charset.name = "ascii";
+    for (uint32_t c = 32; c < 127; ++c) charset.codepoints.push_back(c);
+    return charset;
+}
+
+static uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc) {
+    static const std::vector<uint32_t> table = [] {
+        std::vector<uint32_t> t(256);
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[n] = c;
+        }
+        return t;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < length; ++i) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void appendU32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) out.push_back((uint8_t)(value >> shift));
+}
+
+static void appendChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data) {
+    appendU32(out, (uint32_t)data.size());
+    size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    appendU32(out, crc32(out.data() + start, out.size() - start, 0));
+}
+
+/**
+ * PNG of an 8-bit page (1, 3 or 4 channels, rows top first). Deflate stored blocks, so no
+ * compression library is needed; pipelines that care about size recompress downstream.
+ */
+static void encodePng(const uint8_t* pixels, int width, int height, int channels, int rowStride,
+                      std::vector<uint8_t>& out) {
+    size_t rowBytes = (size_t)width * channels;
+    std::vector<uint8_t> raw;
+    raw.reserve((rowBytes + 1) * height);
+    for (int y = 0; y < height; ++y) {
+        raw.push_back(0); // Filter: none
+        const uint8_t* row = pixels + (size_t)y * rowStride;
+        raw.insert(raw.end(), row, row + rowBytes);
+    }
+
+    std::vector<uint8_t> zlib = { 0x78, 0x01 };
+    size_t pos = 0;
+    for (;;) {
+        size_t length = std::min<size_t>(raw.size() - pos, 65535);
+        bool last = pos + length == raw.size();
+        zlib.push_back(last ? 1 : 0);
+        zlib.push_back((uint8_t)length);
+        zlib.push_back((uint8_t)(length >> 8));
+        zlib.push_back((uint8_t)~length);
+        zlib.push_back((uint8_t)(~length >> 8));
+        zlib.insert(zlib.end(), raw.begin() + pos, raw.begin() + pos + length);
+        pos += length;
+        if (last) break;
+    }
+    uint32_t a = 1, b = 0;
+    for (uint8_t byte : raw) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    appendU32(zlib, b << 16 | a);
+
+    std::vector<uint8_t> header;
+    appendU32(header, (uint32_t)width);
+    appendU32(header, (uint32_t)height);
+    header.push_back(8); // Bit depth
+    header.push_back(channels == 1 ? 0 : (channels == 3 ? 2 : 6)); // Gray, RGB or RGBA
+    header.push_back(0);
+    header.push_back(0);
+    header.push_back(0);
+
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    out.assign(signature, signature + 8);
+    appendChunk(out, "IHDR", header);
+    appendChunk(out, "IDAT", zlib);
+    appendChunk(out, "IEND", std::vector<uint8_t>());
+}
+
+static void appendf(std::string& out, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+static void appendf(std::string& out, const char* format, ...) {
+    char buffer[512];
+    va_list args;
+    va_start(args, format);
+    int length = std::vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length > 0) out.append(buffer, std::min<size_t>((size_t)length, sizeof(buffer) - 1));
+}
+
+static std::string jsonString(const char* text) {
+    std::string out = "\"";
+    for (const char* c = text ? text : ""; *c; ++c) {
+        if (*c == '"' || *c == '\\') out += '\\';
+        if ((unsigned char)*c >= 0x20) out += *c;
+    }
+    return out + "\"";
+}
+
+/**
+ * BMFont-style JSON, as in example/assets/atlas.json: y is the slot's top row (the page is
+ * baked top-down), yoffset runs down from the top of the line (base = ascender). Adds
+ * msdf-bmfont-xml's distanceField block and a kernings block of the charset's kerned pairs.
+ * pages names the PNG; without one it is empty, as BMFont readers expect an image there,
+ * and the page is only in the .msda named by atlasFile (pixelOffset in its header).
+ */
+static std::string atlasJson(msdf_core::FontSession& session, const msdf_core::AtlasResult& atlas,
+                             const Charset& charset, double fontSize, int mode, double pixelRange,
+                             const std::string& atlasFile, const std::string& png) {
+    msdf_core::LayoutMetrics line;
+    if (!msdf_core::layoutMetrics(session, fontSize, line)) {
+        line.ascender = fontSize;
+        line.lineHeight = fontSize;
+    }
+
+    std::string json = "{\n  \"pages\": [" + (png.empty() ? std::string() : jsonString(png.c_str())) + "],\n";
+    json += "  \"atlasFile\": " + jsonString(atlasFile.c_str()) + ",\n  \"chars\": [";
+    bool first = true;
+    for (const msdf_core::AtlasGlyph& glyph : atlas.glyphs) {
+        if (!glyph.placed) continue;
+        appendf(json, "%s\n    { \"id\": %u, \"x\": %d, \"y\": %d, \"width\": %d, \"height\": %d, "
+                      "\"xoffset\": %.7g, \"yoffset\": %.7g, \"xadvance\": %.7g, \"page\": 0, \"chnl\": 15 }",
+                first ? "" : ",", glyph.codepoint, glyph.x, glyph.y, glyph.width, glyph.height,
+                glyph.xoffset, line.ascender - glyph.yoffset, glyph.xadvance);
+        first = false;
+    }
+    json += "\n  ],\n  \"info\": { \"face\": " + jsonString(session.face->family_name);
+    appendf(json, ", \"size\": %.7g, \"type\": \"%s\" },\n", fontSize, MODE_NAMES[mode]);
+    appendf(json, "  \"common\": { \"lineHeight\": %.7g, \"base\": %.7g, \"scaleW\": %d, \"scaleH\": %d, \"pages\": 1 },\n",
+            line.lineHeight, line.ascender, atlas.width, atlas.height);
+    appendf(json, "  \"distanceField\": { \"fieldType\": \"%s\", \"distanceRange\": %.7g },\n  \"kernings\": [",
+            MODE_NAMES[mode], pixelRange);
+
+    int count = (int)charset.codepoints.size();
+    int pairs = msdf_core::kerningTable(session, charset.codepoints.data(), count, fontSize, nullptr, nullptr, 0);
+    std::vector<uint32_t> codes((size_t)pairs * 2);
+    std::vector<float> amounts(pairs);
+    msdf_core::kerningTable(session, charset.codepoints.data(), count, fontSize, codes.data(), amounts.data(), pairs);
+    for (int i = 0; i < pairs; ++i) {
+        appendf(json, "%s\n    { \"first\": %u, \"second\": %u, \"amount\": %.7g }",
+                i ? "," : "", codes[i * 2], codes[i * 2 + 1], amounts[i]);
+    }
+    json += pairs ? "\n  ]\n}\n" : "]\n}\n";
+    return json;
+}
+
+struct Job {
+    const FontInput* font;
+    const Charset* charset;
+    double size;
+    int mode;
+    std::string stem;           // Output path without extension
+};
+
+enum JobResult { JOB_FAILED, JOB_SKIPPED, JOB_BAKED };
+
+// Row order of baked pages: top-down, like BMFont coordinates and PNG rows
+static msdf_core::OutputLayout bakeLayout() {
+    msdf_core::OutputLayout layout;
+    layout.topDown = true;
+    return layout;
+}
+
+// True when the atlas file exists with the same input hashes, and so do its companions
+static bool upToDate(const std::string& stem, uint64_t fontHash, uint64_t settingsHash, const Options& opt) {
+    std::ifstream file(stem + ".msda", std::ios::binary | std::ios::ate);
+    if (!file) return false;
+    size_t length = (size_t)file.tellg();
+    uint8_t bytes[sizeof(msdf_core::AtlasFileHeader)];
+    file.seekg(0);
+    if (!file.read((char*)bytes, sizeof(bytes))) return false;
+
+    msdf_core::AtlasFileHeader header;
+    if (!msdf_core::readAtlasFileHeader(bytes, length, header)) return false;
+    uint64_t storedFont = (uint64_t)header.fontHash[1] << 32 | header.fontHash[0];
+    uint64_t storedSettings = (uint64_t)header.settingsHash[1] << 32 | header.settingsHash[0];
+    return storedFont == fontHash && storedSettings == settingsHash &&
+           std::filesystem::exists(stem + ".json") && (!opt.png || std::filesystem::exists(stem + ".png"));
+}
+
+static JobResult runJob(const Job& job, const Options& opt, std::string& report) {
+    const std::vector<uint32_t>& codepoints = job.charset->codepoints;
+    int count = (int)codepoints.size();
+    int numAxes = (int)opt.axes.size();
+    msdf_core::OutputLayout layout = bakeLayout();
+    uint64_t settings = msdf_core::atlasSettingsHash(codepoints.data(), count, job.size, opt.pixelRange, opt.maxSize,
+                                                     job.mode, opt.format, opt.axes.data(), numAxes, opt.raster, layout);
+    if (!opt.force && upToDate(job.stem, job.font->hash, settings, opt)) return JOB_SKIPPED;
+
+    Clock::time_point start = Clock::now();
+    msdf_core::FontSession* session = msdf_core::openFontView(job.font->data.data(), (int)job.font->data.size());
+    if (!session) {
+        report = "cannot load font";
+        return JOB_FAILED;
+    }
+    session->contentHash = job.font->hash;
+    msdf_core::setSessionAxes(*session, opt.axes.data(), numAxes);
+
+    std::vector<float> pixels;
+    std::vector<uint8_t> bytes;
+    msdf_core::AtlasResult atlas = msdf_core::generateAtlas(
+        *session, job.mode, opt.format, codepoints.data(), count, job.size, opt.pixelRange, opt.maxSize,
+        opt.axes.data(), numAxes, pixels, bytes, opt.raster, layout
+    );
+    JobResult result = JOB_FAILED;
+    if (!atlas.success) {
+        report = "no glyph could be generated";
+    } else {
+        const void* page = opt.format == msdf_core::FORMAT_UINT8 ? (const void*)bytes.data() : (const void*)pixels.data();
+        std::vector<uint8_t> file;
+        msdf_core::writeAtlasFile(atlas, page, job.mode, opt.format, job.size, opt.pixelRange, job.font->hash,
+                                  settings, opt.axes.data(), numAxes, file, layout);
+        std::string name = std::filesystem::path(job.stem).filename().string();
+        std::string json = atlasJson(*session, atlas, *job.charset, job.size, job.mode, opt.pixelRange,
+                                     name + ".msda", opt.png ? name + ".png" : std::string());
+        std::vector<uint8_t> png;
+        if (opt.png) encodePng(bytes.data(), atlas.width, atlas.height, atlas.channels, atlas.rowStride, png);
+
+        // The atlas file goes last: it is what marks the job as done
+        if (!writeFile(job.stem + ".json", json) || (opt.png && !writeFile(job.stem + ".png", png.data(), png.size())) ||
+            !writeFile(job.stem + ".msda", file.data(), file.size())) {
+            report = "cannot write output";
+        } else {
+            int placed = 0;
+            for (const msdf_core::AtlasGlyph& glyph : atlas.glyphs) placed += glyph.placed ? 1 : 0;
+            char line[128];
+            std::snprintf(line, sizeof(line), "%dx%d, %d glyphs", atlas.width, atlas.height, placed);
+            report = line;
+            if (placed < count) {
+                std::snprintf(line, sizeof(line), " (%d missing from the font or over --max-size)", count - placed);
+                report += line;
+            }
+            std::snprintf(line, sizeof(line), ", %.1f ms", elapsedMs(start));
+            report += line;
+            result = JOB_BAKED;
+        }
+    }
+    msdf_core::closeFont(session);
+    return result;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) {
+        usage();
+        return 2;
+    }
+
+    std::vector<FontInput> fonts(opt.fonts.size());
+    for (size_t i = 0; i < opt.fonts.size(); ++i) {
+        if (!readFile(opt.fonts[i], fonts[i].data)) {
+            std::fprintf(stderr, "cannot read %s\n", opt.fonts[i]);
+            return 1;
+        }
+        fonts[i].name = fileStem(opt.fonts[i]);
+        fonts[i].hash = msdf_core::hashBytes(fonts[i].data.data(), fonts[i].data.size());
+    }
+    std::vector<Charset> charsets;
+    for (const char* path : opt.charsets) {
+        Charset charset;
+        charset.name = fileStem(path);
+        if (!readCharset(path, charset.codepoints)) {
+            std::fprintf(stderr, "cannot read charset %s\n", path);
+            return 1;
+        }
+        charsets.push_back(charset);
+    }
+    if (charsets.empty()) charsets.push_back(asciiCharset());
+
+    std::error_code error;
+    std::filesystem::create_directories(opt.outDir, error);
+    if (error) {
+        std::fprintf(stderr, "cannot create %s\n", opt.outDir.c_str());
+        return 1;
+    }
+
+    std::vector<Job> jobs;
+    for (const FontInput& font : fonts) {
+        for (const Charset& charset : charsets) {
+            for (double size : opt.sizes) {
+                for (int mode : opt.modes) {
+                    char suffix[64];
+                    std::snprintf(suffix, sizeof(suffix), "-%g-%s", size, MODE_NAMES[mode]);
+                    std::string stem = (std::filesystem::path(opt.outDir) / (font.name + "-" + charset.name + suffix)).string();
+                    for (const Job& other : jobs) {
+                        if (other.stem == stem) {
+                            std::fprintf(stderr, "two jobs would write %s (same font or charset file name)\n", stem.c_str());
+                            return 1;
+                        }
+                    }
+                    jobs.push_back({ &font, &charset, size, mode, stem });
+                }
+            }
+        }
+    }
+
+    int cores = (int)std::thread::hardware_concurrency();
+    int threads = opt.jobs > 0 ? opt.jobs : (cores > 0 ? cores : 1);
+    std::atomic<int> baked(0), skipped(0), failed(0);
+    auto run = [&](const Job& job) {
+        std::string report;
+        JobResult result = runJob(job, opt, report);
+        std::string name = std::filesystem::path(job.stem).filename().string();
+        if (result == JOB_BAKED) {
+            baked++;
+            std::printf("baked    %s: %s\n", name.c_str(), report.c_str());
+        } else if (result == JOB_SKIPPED) {
+            skipped++;
+            std::printf("current  %s\n", name.c_str());
+        } else {
+            failed++;
+            std::fprintf(stderr, "FAILED   %s: %s\n", name.c_str(), report.c_str());
+        }
+    };
+
+    Clock::time_point start = Clock::now();
+#ifdef MSDF_THREADS
+    // The pool serves one caller at a time: atlases in turn, each one's glyphs across all threads
+    msdf_core::setThreadCount(threads);
+    for (const Job& job : jobs) run(job);
+#else
+    // One atlas per thread, each with its own font session
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < std::min<int>(threads, (int)jobs.size()); ++t) {
+        workers.emplace_back([&] {
+            for (size_t i = next++; i < jobs.size(); i = next++) run(jobs[i]);
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+#endif
+
+    std::printf("%d baked, %d up to date, %d failed (%d threads, %.0f ms)\n",
+                baked.load(), skipped.load(), failed.load(), threads, elapsedMs(start));
+    return failed ? 1 : 0;
+}